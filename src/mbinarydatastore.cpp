@@ -0,0 +1,659 @@
+/***************************************************************************
+** Copyright (C) 2026 Jolla Ltd.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#include <QDataStream>
+#include <QDir>
+#include <QFileInfo>
+#include <QLockFile>
+#include <QPair>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <limits.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "mbinarydatastore.h"
+#include "mbinarydatastore_p.h"
+#include "mfilewatcher_p.h"
+#include "logging.h"
+
+namespace {
+const char Magic[4] = { 'M', 'L', 'D', 'S' };
+const quint32 FormatVersion = 1;
+// Fixed, so values written by one Qt version can be read by another.
+const int DataStreamVersion = QDataStream::Qt_5_6;
+
+quint32 align8(quint32 offset)
+{
+    return (offset + 7) & ~quint32(7);
+}
+
+QString fromUtf16Le(const uchar *data, int length)
+{
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    return QString(reinterpret_cast<const QChar *>(data), length);
+#else
+    QString string(length, Qt::Uninitialized);
+    for (int i = 0; i < length; ++i)
+        string[i] = QChar(qFromLittleEndian<quint16>(data + 2 * i));
+    return string;
+#endif
+}
+
+void toUtf16Le(const QString &string, uchar *data)
+{
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    memcpy(data, string.utf16(), string.size() * 2);
+#else
+    for (int i = 0; i < string.size(); ++i)
+        qToLittleEndian<quint16>(string.at(i).unicode(), data + 2 * i);
+#endif
+}
+}
+
+MBinaryDataStoreTable::MBinaryDataStoreTable()
+    : data(0)
+    , size(0)
+    , entryCount(0)
+    , exists(false)
+    , fileSize(0)
+{
+}
+
+MBinaryDataStoreTable::~MBinaryDataStoreTable()
+{
+}
+
+void MBinaryDataStoreTable::reset()
+{
+    file.close();
+    buffer.clear();
+    data = 0;
+    size = 0;
+    entryCount = 0;
+}
+
+bool MBinaryDataStoreTable::open(const QString &filePath, bool checkKeyOrder)
+{
+    reset();
+
+    file.setFileName(filePath);
+    const QFileInfo info(filePath);
+    exists = info.exists();
+    modified = info.lastModified();
+    fileSize = info.size();
+    if (!exists)
+        return true;
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCWarning(lcMlite) << "Could not open data store" << filePath << file.errorString();
+        return false;
+    }
+
+    size = file.size();
+    if (size == 0)
+        return true;
+
+    data = size >= HeaderSize ? file.map(0, size) : 0;
+    if (!data && size >= HeaderSize) {
+        buffer = file.readAll();
+        data = reinterpret_cast<const uchar *>(buffer.constData());
+        size = buffer.size();
+    }
+
+    // Check that everything the entries refer to is in the file, and optionally that the keys
+    // are sorted, so lookups can trust them. The values themselves are only decoded when read.
+    bool valid = data && size >= HeaderSize && size <= INT_MAX
+            && memcmp(data, Magic, sizeof(Magic)) == 0
+            && word(4) == FormatVersion
+            && HeaderSize + qint64(word(8)) * EntrySize <= size;
+    if (valid) {
+        entryCount = word(8);
+        for (int i = 0; i < entryCount && valid; ++i) {
+            const qint64 offset = entry(i) - data;
+            const qint64 keyOffset = word(offset);
+            const qint64 valueOffset = word(offset + 12);
+            valid = keyOffset % 2 == 0
+                    && keyOffset + 2 * qint64(word(offset + 4)) <= size
+                    && valueOffset + word(offset + 16) <= size
+                    && (!checkKeyOrder || i == 0 || rawKey(i - 1).compare(rawKey(i)) < 0);
+        }
+    }
+
+    if (!valid) {
+        qCWarning(lcMlite) << "Data store" << filePath << "is not in the data store format";
+        reset();
+        return false;
+    }
+    return true;
+}
+
+bool MBinaryDataStoreTable::isOutdated() const
+{
+    const QFileInfo info(file.fileName());
+    if (info.exists() != exists)
+        return true;
+    if (!exists)
+        return false;
+    if (info.lastModified() != modified || info.size() != fileSize)
+        return true;
+
+    // A write within the timestamp granularity may keep both, but replaces the file, and the
+    // replacement can't reuse the inode of the file kept open here.
+    struct stat current;
+    struct stat opened;
+    return file.isOpen()
+            && ::stat(QFile::encodeName(file.fileName()).constData(), &current) == 0
+            && ::fstat(file.handle(), &opened) == 0
+            && (current.st_ino != opened.st_ino || current.st_dev != opened.st_dev);
+}
+
+quint32 MBinaryDataStoreTable::word(qint64 offset) const
+{
+    return qFromLittleEndian<quint32>(data + offset);
+}
+
+int MBinaryDataStoreTable::lowerBound(const QString &key) const
+{
+    int first = 0;
+    int last = entryCount;
+    while (first < last) {
+        const int middle = first + (last - first) / 2;
+        if (rawKey(middle).compare(key) < 0)
+            first = middle + 1;
+        else
+            last = middle;
+    }
+    return first;
+}
+
+int MBinaryDataStoreTable::find(const QString &key) const
+{
+    const int index = lowerBound(key);
+    return index < entryCount && rawKey(index) == key ? index : -1;
+}
+
+QString MBinaryDataStoreTable::key(int index) const
+{
+    const uchar *e = entry(index);
+    return fromUtf16Le(data + qFromLittleEndian<quint32>(e), qFromLittleEndian<quint32>(e + 4));
+}
+
+QString MBinaryDataStoreTable::rawKey(int index) const
+{
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    const uchar *e = entry(index);
+    return QString::fromRawData(reinterpret_cast<const QChar *>(data + qFromLittleEndian<quint32>(e)),
+                                qFromLittleEndian<quint32>(e + 4));
+#else
+    return key(index);
+#endif
+}
+
+const uchar *MBinaryDataStoreTable::valueData(int index, quint32 *type, quint32 *size) const
+{
+    const uchar *e = entry(index);
+    *type = qFromLittleEndian<quint32>(e + 8);
+    *size = qFromLittleEndian<quint32>(e + 16);
+    return data + qFromLittleEndian<quint32>(e + 12);
+}
+
+QVariant MBinaryDataStoreTable::value(int index) const
+{
+    quint32 type;
+    quint32 size;
+    const uchar *value = valueData(index, &type, &size);
+
+    switch (type) {
+    case BoolType:
+        if (size >= 1)
+            return QVariant(value[0] != 0);
+        break;
+    case IntType:
+        if (size >= 4)
+            return QVariant(int(qFromLittleEndian<qint32>(value)));
+        break;
+    case UIntType:
+        if (size >= 4)
+            return QVariant(uint(qFromLittleEndian<quint32>(value)));
+        break;
+    case LongLongType:
+        if (size >= 8)
+            return QVariant(qlonglong(qFromLittleEndian<qint64>(value)));
+        break;
+    case ULongLongType:
+        if (size >= 8)
+            return QVariant(qulonglong(qFromLittleEndian<quint64>(value)));
+        break;
+    case DoubleType:
+        if (size >= 8) {
+            const quint64 bits = qFromLittleEndian<quint64>(value);
+            double number;
+            memcpy(&number, &bits, sizeof(number));
+            return QVariant(number);
+        }
+        break;
+    case StringType:
+        return QVariant(fromUtf16Le(value, size / 2));
+    case ByteArrayType:
+        return QVariant(QByteArray(reinterpret_cast<const char *>(value), size));
+    case VariantType: {
+        const QByteArray raw = QByteArray::fromRawData(reinterpret_cast<const char *>(value), size);
+        QDataStream stream(raw);
+        stream.setVersion(DataStreamVersion);
+        QVariant variant;
+        stream >> variant;
+        return variant;
+    }
+    default:
+        break;
+    }
+    return QVariant();
+}
+
+bool MBinaryDataStoreTable::equalValue(int index, quint32 type, const QByteArray &data) const
+{
+    quint32 valueType;
+    quint32 size;
+    const uchar *value = valueData(index, &valueType, &size);
+    return valueType == type && size == quint32(data.size()) && memcmp(value, data.constData(), size) == 0;
+}
+
+bool MBinaryDataStoreTable::equalValues(int index, const MBinaryDataStoreTable &other, int otherIndex) const
+{
+    quint32 type;
+    quint32 size;
+    const uchar *value = valueData(index, &type, &size);
+    quint32 otherType;
+    quint32 otherSize;
+    const uchar *otherValue = other.valueData(otherIndex, &otherType, &otherSize);
+    return type == otherType && size == otherSize && memcmp(value, otherValue, size) == 0;
+}
+
+void MBinaryDataStoreTable::encode(const QVariant &value, quint32 *type, QByteArray *data)
+{
+    data->clear();
+    switch (value.userType()) {
+    case QMetaType::Bool:
+        *type = BoolType;
+        data->append(char(value.toBool() ? 1 : 0));
+        return;
+    case QMetaType::Int:
+        *type = IntType;
+        data->resize(4);
+        qToLittleEndian<qint32>(value.toInt(), reinterpret_cast<uchar *>(data->data()));
+        return;
+    case QMetaType::UInt:
+        *type = UIntType;
+        data->resize(4);
+        qToLittleEndian<quint32>(value.toUInt(), reinterpret_cast<uchar *>(data->data()));
+        return;
+    case QMetaType::LongLong:
+        *type = LongLongType;
+        data->resize(8);
+        qToLittleEndian<qint64>(value.toLongLong(), reinterpret_cast<uchar *>(data->data()));
+        return;
+    case QMetaType::ULongLong:
+        *type = ULongLongType;
+        data->resize(8);
+        qToLittleEndian<quint64>(value.toULongLong(), reinterpret_cast<uchar *>(data->data()));
+        return;
+    case QMetaType::Double: {
+        *type = DoubleType;
+        const double number = value.toDouble();
+        quint64 bits;
+        memcpy(&bits, &number, sizeof(bits));
+        data->resize(8);
+        qToLittleEndian<quint64>(bits, reinterpret_cast<uchar *>(data->data()));
+        return;
+    }
+    case QMetaType::QString: {
+        *type = StringType;
+        const QString string = value.toString();
+        data->resize(string.size() * 2);
+        toUtf16Le(string, reinterpret_cast<uchar *>(data->data()));
+        return;
+    }
+    case QMetaType::QByteArray:
+        *type = ByteArrayType;
+        *data = value.toByteArray();
+        return;
+    default: {
+        *type = VariantType;
+        QDataStream stream(data, QIODevice::WriteOnly);
+        stream.setVersion(DataStreamVersion);
+        stream << value;
+        return;
+    }
+    }
+}
+
+QVector<MBinaryDataStoreTable::Item> MBinaryDataStoreTable::items() const
+{
+    QVector<Item> items;
+    items.reserve(entryCount);
+    for (int i = 0; i < entryCount; ++i) {
+        Item item;
+        item.key = key(i);
+        quint32 size;
+        const uchar *value = valueData(i, &item.type, &size);
+        item.data = QByteArray::fromRawData(reinterpret_cast<const char *>(value), size);
+        items.append(item);
+    }
+    return items;
+}
+
+QByteArray MBinaryDataStoreTable::serialize(const QVector<Item> &items)
+{
+    qint64 total = HeaderSize + qint64(items.count()) * EntrySize;
+    for (const Item &item : items)
+        total += 2 * qint64(item.key.size());
+    const qint64 valuesOffset = (total + 7) & ~qint64(7);
+    total = valuesOffset;
+    for (const Item &item : items)
+        total += align8(item.data.size());
+    if (total > INT_MAX)
+        return QByteArray();
+
+    QByteArray content(int(total), '\0');
+    uchar *out = reinterpret_cast<uchar *>(content.data());
+    memcpy(out, Magic, sizeof(Magic));
+    qToLittleEndian<quint32>(FormatVersion, out + 4);
+    qToLittleEndian<quint32>(items.count(), out + 8);
+
+    quint32 keyOffset = HeaderSize + items.count() * EntrySize;
+    quint32 valueOffset = quint32(valuesOffset);
+    uchar *e = out + HeaderSize;
+    for (const Item &item : items) {
+        qToLittleEndian<quint32>(keyOffset, e);
+        qToLittleEndian<quint32>(item.key.size(), e + 4);
+        qToLittleEndian<quint32>(item.type, e + 8);
+        qToLittleEndian<quint32>(valueOffset, e + 12);
+        qToLittleEndian<quint32>(item.data.size(), e + 16);
+        e += EntrySize;
+
+        toUtf16Le(item.key, out + keyOffset);
+        keyOffset += 2 * item.key.size();
+        memcpy(out + valueOffset, item.data.constData(), item.data.size());
+        valueOffset = align8(valueOffset + item.data.size());
+    }
+    return content;
+}
+
+MBinaryDataStorePrivate::MBinaryDataStorePrivate(const QString &filePath, MBinaryDataStore *q)
+    : q_ptr(q)
+    , filePath(filePath)
+    , lockFileName(filePath + QStringLiteral(".lock"))
+    , table(new MBinaryDataStoreTable)
+    // The key order isn't checked when starting up, comparing all the keys would touch the
+    // whole key table. Unsorted keys only make lookups miss, and are rejected when reloading.
+    , readable(table->open(filePath, false))
+{
+}
+
+void MBinaryDataStorePrivate::watch()
+{
+    Q_Q(MBinaryDataStore);
+    if (MFileWatcher *watcher = MFileWatcher::instance())
+        watcher->addFile(filePath, q);
+}
+
+void MBinaryDataStorePrivate::reload(ChangeList *changes)
+{
+    QScopedPointer<MBinaryDataStoreTable> previous(new MBinaryDataStoreTable);
+    previous.swap(table);
+    readable = table->open(filePath, true);
+
+    // Walk the old and new keys in order to find the changed, removed and added ones.
+    // Values are compared in their encoded form without decoding them.
+    int i = 0;
+    int j = 0;
+    while (i < previous->count() || j < table->count()) {
+        const int order = i >= previous->count() ? 1
+                : j >= table->count() ? -1
+                : previous->rawKey(i).compare(table->rawKey(j));
+        if (order < 0) {
+            changes->append(qMakePair(previous->key(i), QVariant()));
+            ++i;
+        } else if (order > 0) {
+            changes->append(qMakePair(table->key(j), table->value(j)));
+            ++j;
+        } else {
+            if (!table->equalValues(j, *previous, i))
+                changes->append(qMakePair(table->key(j), table->value(j)));
+            ++i;
+            ++j;
+        }
+    }
+}
+
+bool MBinaryDataStorePrivate::lock(QLockFile *lockFile, ChangeList *changes)
+{
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+    if (!lockFile->lock()) {
+        qCWarning(lcMlite) << "Could not lock data store" << filePath << lockFile->error();
+        return false;
+    }
+
+    // Don't overwrite changes which haven't been noticed yet
+    if (table->isOutdated())
+        reload(changes);
+    return readable;
+}
+
+bool MBinaryDataStorePrivate::write(const QString &key, const MBinaryDataStoreTable::Item *item)
+{
+    // The items refer to the mapped file, which stays mapped until the new one is.
+    QVector<MBinaryDataStoreTable::Item> items = table->items();
+    const int index = table->lowerBound(key);
+    const bool found = index < table->count() && table->rawKey(index) == key;
+    if (item && found)
+        items[index] = *item;
+    else if (item)
+        items.insert(index, *item);
+    else if (found)
+        items.remove(index);
+
+    return replaceFile(MBinaryDataStoreTable::serialize(items));
+}
+
+bool MBinaryDataStorePrivate::replaceFile(const QByteArray &content)
+{
+    if (content.isEmpty()) {
+        qCWarning(lcMlite) << "Data store" << filePath << "would be too large";
+        return false;
+    }
+
+    // Written to a temporary file which is renamed over the original, so readers
+    // which have the original mapped keep seeing it intact.
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(content) != content.size() || !file.commit()) {
+        qCWarning(lcMlite) << "Could not write data store" << filePath << file.errorString();
+        return false;
+    }
+
+    QScopedPointer<MBinaryDataStoreTable> written(new MBinaryDataStoreTable);
+    readable = written->open(filePath, true);
+    table.swap(written);
+    watch();
+    return true;
+}
+
+MBinaryDataStore::MBinaryDataStore(const QString &filePath)
+    : d_ptr(new MBinaryDataStorePrivate(filePath, this))
+{
+    Q_D(MBinaryDataStore);
+    d->watch();
+}
+
+MBinaryDataStore::~MBinaryDataStore()
+{
+    Q_D(MBinaryDataStore);
+    if (MFileWatcher *watcher = MFileWatcher::instance())
+        watcher->removeFile(d->filePath, this);
+    delete d_ptr;
+}
+
+bool MBinaryDataStore::createValue(const QString &key, const QVariant &value)
+{
+    Q_D(MBinaryDataStore);
+    if (!isWritable())
+        return false;
+
+    // Signaled after unlocking, slots may write again
+    MBinaryDataStorePrivate::ChangeList changes;
+    bool written = false;
+    {
+        QLockFile lockFile(d->lockFileName);
+        if (d->lock(&lockFile, &changes)) {
+            MBinaryDataStoreTable::Item item;
+            item.key = key;
+            MBinaryDataStoreTable::encode(value, &item.type, &item.data);
+
+            const int index = d->table->find(key);
+            if (index >= 0 && d->table->equalValue(index, item.type, item.data)) {
+                written = true;
+            } else if (d->write(key, &item)) {
+                written = true;
+                changes.append(qMakePair(key, value));
+            }
+        }
+    }
+    emitChanges(changes);
+    return written;
+}
+
+bool MBinaryDataStore::setValue(const QString &key, const QVariant &value)
+{
+    Q_D(MBinaryDataStore);
+    if (!isWritable())
+        return false;
+
+    MBinaryDataStorePrivate::ChangeList changes;
+    bool written = false;
+    {
+        QLockFile lockFile(d->lockFileName);
+        const int index = d->lock(&lockFile, &changes) ? d->table->find(key) : -1;
+        if (index >= 0) {
+            MBinaryDataStoreTable::Item item;
+            item.key = key;
+            MBinaryDataStoreTable::encode(value, &item.type, &item.data);
+
+            if (d->table->equalValue(index, item.type, item.data)) {
+                written = true;
+            } else if (d->write(key, &item)) {
+                written = true;
+                changes.append(qMakePair(key, value));
+            }
+        }
+    }
+    emitChanges(changes);
+    return written;
+}
+
+QVariant MBinaryDataStore::value(const QString &key) const
+{
+    Q_D(const MBinaryDataStore);
+    const int index = d->table->find(key);
+    return index >= 0 ? d->table->value(index) : QVariant();
+}
+
+QStringList MBinaryDataStore::allKeys() const
+{
+    Q_D(const MBinaryDataStore);
+    QStringList keys;
+    keys.reserve(d->table->count());
+    for (int i = 0; i < d->table->count(); ++i)
+        keys.append(d->table->key(i));
+    return keys;
+}
+
+void MBinaryDataStore::remove(const QString &key)
+{
+    Q_D(MBinaryDataStore);
+    if (!isWritable())
+        return;
+
+    MBinaryDataStorePrivate::ChangeList changes;
+    {
+        QLockFile lockFile(d->lockFileName);
+        if (d->lock(&lockFile, &changes) && d->table->find(key) >= 0 && d->write(key, 0))
+            changes.append(qMakePair(key, QVariant()));
+    }
+    emitChanges(changes);
+}
+
+void MBinaryDataStore::clear()
+{
+    Q_D(MBinaryDataStore);
+    if (!isWritable())
+        return;
+
+    MBinaryDataStorePrivate::ChangeList changes;
+    {
+        QLockFile lockFile(d->lockFileName);
+        if (d->lock(&lockFile, &changes)) {
+            const QStringList keys = allKeys();
+            if (d->replaceFile(MBinaryDataStoreTable::serialize(QVector<MBinaryDataStoreTable::Item>()))) {
+                for (const QString &key : keys)
+                    changes.append(qMakePair(key, QVariant()));
+            }
+        }
+    }
+    emitChanges(changes);
+}
+
+bool MBinaryDataStore::contains(const QString &key) const
+{
+    Q_D(const MBinaryDataStore);
+    return d->table->find(key) >= 0;
+}
+
+bool MBinaryDataStore::isReadable() const
+{
+    Q_D(const MBinaryDataStore);
+    return d->readable;
+}
+
+bool MBinaryDataStore::isWritable() const
+{
+    Q_D(const MBinaryDataStore);
+    const QFileInfo file(d->filePath);
+    const QFileInfo directory(file.absolutePath());
+    return d->readable
+            && (!file.exists() || file.isWritable())
+            && (!directory.exists() || directory.isWritable());
+}
+
+void MBinaryDataStore::reload()
+{
+    Q_D(MBinaryDataStore);
+    MBinaryDataStorePrivate::ChangeList changes;
+    d->reload(&changes);
+    emitChanges(changes);
+}
+
+void MBinaryDataStore::emitChanges(const QVector<QPair<QString, QVariant> > &changes)
+{
+    for (const QPair<QString, QVariant> &change : changes)
+        emit valueChanged(change.first, change.second);
+}
+
+void MBinaryDataStore::fileChanged(const QString &fileName)
+{
+    Q_D(MBinaryDataStore);
+    // watch again in case the directory was replaced or deleted
+    d->watch();
+    // Notifications of our own writes find the file as it was written
+    if (fileName == d->filePath && d->table->isOutdated())
+        reload();
+}
@@ -0,0 +1,127 @@
+/***************************************************************************
+** Copyright (C) 2026 Jolla Ltd.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef MBINARYDATASTORE_H_
+#define MBINARYDATASTORE_H_
+
+#include <QPair>
+#include <QVector>
+
+#include "mlite-global.h"
+#include "mdatastore.h"
+
+class MBinaryDataStorePrivate;
+
+/*!
+ * Concrete implementation of \c MDataStore interface which stores the data
+ * in a compact binary file. The file holds a table of the keys in sorted
+ * order followed by the typed values, and is memory mapped, so opening a
+ * store doesn't parse it and looking up a key is a binary search.
+ *
+ * Booleans, integers, doubles, strings and byte arrays are stored as they
+ * are, other values in the QDataStream format. Every change replaces the
+ * file atomically, holding a lock file next to it so concurrent writers in
+ * other instances or processes don't lose each other's changes. Changes made by other instances, also in other
+ * processes, are noticed and signaled with \c valueChanged. The file must
+ * only be modified by replacing it, never in place.
+ *
+ * To keep opening cheap, the order of the keys is only checked when the
+ * file is reloaded or written, not when the store is constructed. The keys
+ * of a file which isn't sorted can't be found until then.
+ */
+class MLITESHARED_EXPORT MBinaryDataStore : public MDataStore
+{
+    Q_OBJECT
+public:
+    /*!
+     * Constructor.
+     * \param filePath Absolute path to the file that the data will be written to and read from.
+     */
+    explicit MBinaryDataStore(const QString &filePath);
+
+    /*!
+     * Destructor
+     */
+    virtual ~MBinaryDataStore();
+
+    //! \reimp
+    /*!
+     * If \c isWritable returns \c false, this method returns \c false.
+     */
+    virtual bool createValue(const QString &key, const QVariant &value);
+    /*!
+     * If \c isWritable returns \c false, this method returns \c false.
+     */
+    virtual bool setValue(const QString &key, const QVariant &value);
+    /*!
+     * If \c isReadable returns \c false, this method returns an empty QVariant.
+     */
+    virtual QVariant value(const QString &key) const;
+    /*!
+     * Returns the keys in sorted order.
+     * If \c isReadable returns \c false, this method returns an empty list.
+     */
+    virtual QStringList allKeys() const;
+    /*!
+     * If \c isWritable returns \c false, this method does nothing.
+     */
+    virtual void remove(const QString &key);
+    /*!
+     * If \c isWritable returns \c false, this method does nothing.
+     */
+    virtual void clear();
+    /*!
+     * If \c isReadable returns \c false, this method returns \c false.
+     */
+    virtual bool contains(const QString &key) const;
+    //! \reimp_end
+
+    /*!
+     * Queries if this data store is readable. A missing file reads as an
+     * empty data store, a file which is not in the data store format
+     * doesn't.
+     * \return \c true if the data store can be read.
+     */
+    bool isReadable() const;
+
+    /*!
+     * Queries if this data store is writable. A data store which is not
+     * readable isn't writable either, so an unknown file is never replaced.
+     * \return \c true if the data store can be written.
+     */
+    bool isWritable() const;
+
+private:
+    /*!
+     * Maps the file again and signals the values which differ from the
+     * ones mapped before.
+     */
+    void reload();
+
+    //! Emits valueChanged for each key and value in \a changes.
+    void emitChanges(const QVector<QPair<QString, QVariant> > &changes);
+
+private slots:
+    /*!
+     * Notifies that the data store file has been changed in the filesystem
+     * \param fileName The name of the file modified
+     */
+    void fileChanged(const QString &fileName);
+
+protected:
+    MBinaryDataStorePrivate * const d_ptr;
+
+private:
+    Q_DECLARE_PRIVATE(MBinaryDataStore)
+    Q_DISABLE_COPY(MBinaryDataStore)
+};
+
+#endif /* MBINARYDATASTORE_H_ */
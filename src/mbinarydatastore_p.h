@@ -0,0 +1,163 @@
+/***************************************************************************
+** Copyright (C) 2026 Jolla Ltd.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef MBINARYDATASTORE_P_H
+#define MBINARYDATASTORE_P_H
+
+#include <QDateTime>
+#include <QFile>
+#include <QPair>
+#include <QScopedPointer>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+
+/*
+ * The file starts with a header of four little endian 32 bit words: the
+ * magic "MLDS", the format version and the number of entries, and one
+ * reserved word. The entries follow, sorted by key, each five words: the
+ * offset and length in UTF-16 code units of the key, the value type, and
+ * the offset and size in bytes of the value. Keys are stored in UTF-16LE,
+ * values 8 byte aligned after the keys. Numbers are little endian.
+ */
+class MBinaryDataStoreTable
+{
+public:
+    enum ValueType {
+        BoolType = 1,
+        IntType,
+        UIntType,
+        LongLongType,
+        ULongLongType,
+        DoubleType,
+        StringType,
+        ByteArrayType,
+        //! Any other value in QDataStream format
+        VariantType
+    };
+
+    MBinaryDataStoreTable();
+    ~MBinaryDataStoreTable();
+
+    /*!
+     * Maps the file. A missing file is an empty table. The entries are checked to stay
+     * within the file, and the keys to be sorted if \a checkKeyOrder is true.
+     * \return false if the file can't be read or isn't in the data store format.
+     */
+    bool open(const QString &filePath, bool checkKeyOrder);
+
+    //! Returns whether the file has been replaced or modified since it was opened
+    bool isOutdated() const;
+
+    int count() const { return entryCount; }
+
+    //! Returns the index of the first key not less than \a key
+    int lowerBound(const QString &key) const;
+    //! Returns the index of \a key, or -1 if the table doesn't have it
+    int find(const QString &key) const;
+    QString key(int index) const;
+    //! Returns the key of \a index referring to the mapped file where possible, valid while the table is
+    QString rawKey(int index) const;
+    QVariant value(int index) const;
+    //! Returns whether the value at \a index has the given encoded type and data
+    bool equalValue(int index, quint32 type, const QByteArray &data) const;
+    //! Returns whether the value at \a index has the same type and bytes as the value at \a otherIndex of \a other
+    bool equalValues(int index, const MBinaryDataStoreTable &other, int otherIndex) const;
+
+    //! Encodes \a value into \a type and \a data
+    static void encode(const QVariant &value, quint32 *type, QByteArray *data);
+
+    struct Item
+    {
+        QString key;
+        quint32 type;
+        QByteArray data;
+    };
+
+    //! Returns the items of the table, the data referring to the mapped file
+    QVector<Item> items() const;
+
+    //! Returns the file content of \a items, which must be sorted by key
+    static QByteArray serialize(const QVector<Item> &items);
+
+private:
+    quint32 word(qint64 offset) const;
+    const uchar *entry(int index) const { return data + HeaderSize + qint64(index) * EntrySize; }
+    const uchar *valueData(int index, quint32 *type, quint32 *size) const;
+    void reset();
+
+    enum { HeaderSize = 16, EntrySize = 20 };
+
+    QFile file;
+    //! The file content if it couldn't be mapped
+    QByteArray buffer;
+    const uchar *data;
+    qint64 size;
+    int entryCount;
+    //! What the file was like when it was opened
+    bool exists;
+    QDateTime modified;
+    qint64 fileSize;
+
+    Q_DISABLE_COPY(MBinaryDataStoreTable)
+};
+
+class MBinaryDataStore;
+class QLockFile;
+
+class MBinaryDataStorePrivate
+{
+public:
+    typedef QVector<QPair<QString, QVariant> > ChangeList;
+
+    MBinaryDataStorePrivate(const QString &filePath, MBinaryDataStore *q);
+
+    /*!
+     * Maps the file again and appends the keys whose values differ from the
+     * ones mapped before to \a changes.
+     */
+    void reload(ChangeList *changes);
+
+    /*!
+     * Locks \a lockFile against other writers and rereads the file if it
+     * has changed, appending the changed values to \a changes.
+     * \return false if the file couldn't be locked or read.
+     */
+    bool lock(QLockFile *lockFile, ChangeList *changes);
+
+    //! Makes the process wide file watcher notify the data store of changes to the file
+    void watch();
+
+    /*!
+     * Replaces the file with the current table where \a key is set to the
+     * value of \a item, or removed if \a item is null, and maps the new file.
+     * \return false if writing failed.
+     */
+    bool write(const QString &key, const MBinaryDataStoreTable::Item *item);
+
+    //! Replaces the file with \a content and maps it.
+    bool replaceFile(const QByteArray &content);
+
+    MBinaryDataStore * const q_ptr;
+
+    const QString filePath;
+    const QString lockFileName;
+
+    //! The mapped file
+    QScopedPointer<MBinaryDataStoreTable> table;
+
+    //! Whether the mapped file could be read
+    bool readable;
+
+    Q_DECLARE_PUBLIC(MBinaryDataStore)
+};
+
+#endif /* MBINARYDATASTORE_P_H */
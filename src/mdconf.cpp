@@ -12,13 +12,186 @@
 #include "mdconf_p.h"
 #include "logging.h"
 
+#include <QCoreApplication>
 #include <QDebug>
+#include <QHash>
 #include <QPoint>
+#include <QPointer>
 #include <QRect>
+#include <QSet>
 #include <QSize>
 #include <QStringList>
 #include <QVector>
 
+#include <string.h>
+
+namespace MDConf {
+
+// Indexes subscribers by path in a trie with one node per path segment, so the subscribers
+// affected by a change are found in time proportional to the length of the changed path.
+// Directory segments retain their trailing '/' to distinguish them from keys of the same name.
+class Router
+{
+public:
+    void insert(const QByteArray &path, QObject *receiver)
+    {
+        Node *node = &root;
+        for (int start = 1, end; start < path.length(); start = end) {
+            end = segmentEnd(path, start);
+            const QByteArray segment = path.mid(start, end - start);
+
+            Node *&child = node->children[segment];
+            if (!child) {
+                child = new Node;
+                child->parent = node;
+                child->segment = segment;
+            }
+            node = child;
+        }
+        node->subscribers.append(receiver);
+    }
+
+    void remove(const QByteArray &path, QObject *receiver)
+    {
+        Node *node = find(path);
+        if (!node || !node->subscribers.removeOne(receiver))
+            return;
+
+        // Prune the branch back to the last node still in use.
+        while (node != &root && node->subscribers.isEmpty() && node->children.isEmpty()) {
+            Node * const parent = node->parent;
+            parent->children.remove(node->segment);
+            delete node;
+            node = parent;
+        }
+    }
+
+    // A change to a key is of interest to the subscribers of that key and of the directory
+    // containing it, a change to a directory to every subscriber below it.
+    void collect(const QByteArray &path, QVector<QPointer<QObject> > &receivers, QSet<QObject *> &seen)
+    {
+        if (path.endsWith('/')) {
+            if (Node *node = find(path))
+                collectAll(node, receivers, seen);
+        } else {
+            const int directoryLength = path.lastIndexOf('/') + 1;
+            if (Node *directory = find(path, directoryLength)) {
+                append(directory, receivers, seen);
+
+                const QByteArray segment = QByteArray::fromRawData(
+                            path.constData() + directoryLength, path.length() - directoryLength);
+                if (Node *key = directory->children.value(segment))
+                    append(key, receivers, seen);
+            }
+        }
+    }
+
+private:
+    struct Node
+    {
+        Node() : parent(0) {}
+        ~Node() { qDeleteAll(children); }
+
+        Node *parent;
+        QByteArray segment;
+        QHash<QByteArray, Node *> children;
+        QVector<QObject *> subscribers;
+    };
+
+    static int segmentEnd(const QByteArray &path, int start)
+    {
+        const int separator = path.indexOf('/', start);
+        return separator != -1 ? separator + 1 : path.length();
+    }
+
+    Node *find(const QByteArray &path, int length = -1)
+    {
+        if (length < 0)
+            length = path.length();
+
+        Node *node = &root;
+        for (int start = 1, end; node && start < length; start = end) {
+            end = qMin(segmentEnd(path, start), length);
+            node = node->children.value(QByteArray::fromRawData(path.constData() + start, end - start));
+        }
+        return node;
+    }
+
+    static void append(const Node *node, QVector<QPointer<QObject> > &receivers, QSet<QObject *> &seen)
+    {
+        for (QObject *receiver : node->subscribers) {
+            if (!seen.contains(receiver)) {
+                seen.insert(receiver);
+                receivers.append(receiver);
+            }
+        }
+    }
+
+    static void collectAll(const Node *node, QVector<QPointer<QObject> > &receivers, QSet<QObject *> &seen)
+    {
+        append(node, receivers, seen);
+        for (const Node *child : node->children)
+            collectAll(child, receivers, seen);
+    }
+
+    Node root;
+};
+
+// Owns the single "changed" handler of a shared client and forwards notifications to the
+// subscribers whose path is affected by a change.
+class Dispatcher
+{
+public:
+    explicit Dispatcher(DConfClient *client)
+        : origin(0)
+        , writing(false)
+    {
+        g_signal_connect(client, "changed", G_CALLBACK(changed), this);
+    }
+
+    static Dispatcher *get(DConfClient *client)
+    {
+        return static_cast<Dispatcher *>(g_object_get_data(G_OBJECT(client), "mlite-dispatcher"));
+    }
+
+    static void destroy(gpointer data)
+    {
+        delete static_cast<Dispatcher *>(data);
+    }
+
+    static void changed(DConfClient *, gchar *prefix, GStrv changes, gchar *, gpointer data)
+    {
+        static_cast<Dispatcher *>(data)->dispatch(prefix, changes);
+    }
+
+    void dispatch(const char *prefix, const gchar * const *changes)
+    {
+        QVector<QPointer<QObject> > receivers;
+        QSet<QObject *> seen;
+        const QByteArray prefixPath(prefix);
+        for (int i = 0; changes[i]; ++i)
+            router.collect(prefixPath + changes[i], receivers, seen);
+
+        // A receiver may delete another while handling its notification, so guard them.
+        for (const QPointer<QObject> &receiver : receivers) {
+            if (!receiver) {
+                continue;
+            } else if (writing && receiver != origin) {
+                QCoreApplication::postEvent(receiver, new Event(prefix, changes));
+            } else {
+                Event event(prefix, changes);
+                QCoreApplication::sendEvent(receiver, &event);
+            }
+        }
+    }
+
+    Router router;
+    QObject *origin;
+    bool writing;
+};
+
+}
+
 template <typename T> static T tupleValue(GVariant *tuple, int index)
 {
     GVariant *child = g_variant_get_child_value(tuple, index);
@@ -28,6 +201,70 @@ template <typename T> static T tupleValue(GVariant *tuple, int index)
     return value.value<T>();
 }
 
+// Reads a tuple of N fields of the fixed size type T directly from its serialized form, which
+// for a fixed size tuple is just the fields in native byte order.
+template <typename T, int N> static bool readFixedTuple(GVariant *value, const char *format, T (&fields)[N])
+{
+    if (g_variant_get_size(value) != sizeof(fields)
+            || !g_variant_is_of_type(value, G_VARIANT_TYPE(format))) {
+        return false;
+    }
+
+    const void *data = g_variant_get_data(value);
+    if (!data)
+        return false;
+
+    memcpy(fields, data, sizeof(fields));
+    return true;
+}
+
+// Reads an array of strings directly from its serialized form.  The strings are stored
+// consecutively with their nul terminators and followed by a table of little endian offsets to
+// the end of each string, the size of an offset depends on the size of the array.  Returns false
+// if the data is not in normal form so the caller can fall back to the GVariant API.
+static bool readStringArray(GVariant *value, QStringList *list)
+{
+    const gsize size = g_variant_get_size(value);
+    if (size == 0)
+        return true;
+
+    const guchar * const data = static_cast<const guchar *>(g_variant_get_data(value));
+    const gsize offsetSize = size > G_MAXUINT32 ? 8 : size > G_MAXUINT16 ? 4 : size > G_MAXUINT8 ? 2 : 1;
+    if (!data || size < offsetSize)
+        return false;
+
+    const auto readOffset = [data, offsetSize](gsize position) {
+        guint64 offset = 0;
+        for (gsize i = 0; i < offsetSize; ++i)
+            offset |= guint64(data[position + i]) << (8 * i);
+        return offset;
+    };
+
+    const guint64 offsetsStart = readOffset(size - offsetSize);
+    if (offsetsStart > size - offsetSize || (size - offsetsStart) % offsetSize != 0)
+        return false;
+
+    const gsize count = (size - offsetsStart) / offsetSize;
+    list->reserve(int(count));
+
+    guint64 start = 0;
+    for (gsize i = 0; i < count; ++i) {
+        const guint64 end = readOffset(offsetsStart + i * offsetSize);
+        const char * const string = reinterpret_cast<const char *>(data) + start;
+        if (end <= start
+                || end > offsetsStart
+                || data[end - 1] != '\0'
+                || memchr(string, '\0', end - start - 1)) {
+            list->clear();
+            return false;
+        }
+        list->append(QString::fromUtf8(string, int(end - start - 1)));
+        start = end;
+    }
+
+    return true;
+}
+
 QVariant MDConf::convertValue(GVariant *value, int typeHint)
 {
     if (!value)
@@ -70,6 +307,8 @@ QVariant MDConf::convertValue(GVariant *value, int typeHint)
             return QVariant::fromValue(QByteArray(g_variant_get_bytestring(value)));
         } else if (g_variant_type_equal(type, G_VARIANT_TYPE_STRING_ARRAY)) {
             QStringList stringList;
+            if (readStringArray(value, &stringList))
+                return stringList;
 
             gsize length = 0;
             const gchar **strings = g_variant_get_strv(value, &length);
@@ -113,24 +352,45 @@ QVariant MDConf::convertValue(GVariant *value, int typeHint)
         }
     }
     case G_VARIANT_CLASS_TUPLE:
+        // Geometry types are stored as tuples of int32 or double, read them directly from the
+        // serialized data if they have the expected type or otherwise convert each member.
         switch (typeHint) {
-        case QMetaType::QPoint:
+        case QMetaType::QPoint: {
+            gint32 fields[2];
+            if (readFixedTuple(value, "(ii)", fields))
+                return QPoint(fields[0], fields[1]);
             if (g_variant_n_children(value) == 2)
                 return QPoint(tupleValue<int>(value, 0), tupleValue<int>(value, 1));
             break;
-        case QMetaType::QPointF:
+        }
+        case QMetaType::QPointF: {
+            gdouble fields[2];
+            if (readFixedTuple(value, "(dd)", fields))
+                return QPointF(fields[0], fields[1]);
             if (g_variant_n_children(value) == 2)
-                return QPoint(tupleValue<qreal>(value, 0), tupleValue<qreal>(value, 1));
+                return QPointF(tupleValue<qreal>(value, 0), tupleValue<qreal>(value, 1));
             break;
-        case QMetaType::QSize:
+        }
+        case QMetaType::QSize: {
+            gint32 fields[2];
+            if (readFixedTuple(value, "(ii)", fields))
+                return QSize(fields[0], fields[1]);
             if (g_variant_n_children(value) == 2)
                 return QSize(tupleValue<int>(value, 0), tupleValue<int>(value, 1));
             break;
-        case QMetaType::QSizeF:
+        }
+        case QMetaType::QSizeF: {
+            gdouble fields[2];
+            if (readFixedTuple(value, "(dd)", fields))
+                return QSizeF(fields[0], fields[1]);
             if (g_variant_n_children(value) == 2)
                 return QSizeF(tupleValue<qreal>(value, 0), tupleValue<qreal>(value, 1));
             break;
-        case QMetaType::QRect:
+        }
+        case QMetaType::QRect: {
+            gint32 fields[4];
+            if (readFixedTuple(value, "(iiii)", fields))
+                return QRect(fields[0], fields[1], fields[2], fields[3]);
             if (g_variant_n_children(value) == 4) {
                 return QRect(
                             tupleValue<qreal>(value, 0),
@@ -139,7 +399,11 @@ QVariant MDConf::convertValue(GVariant *value, int typeHint)
                             tupleValue<qreal>(value, 3));
             }
             break;
-        case QMetaType::QRectF:
+        }
+        case QMetaType::QRectF: {
+            gdouble fields[4];
+            if (readFixedTuple(value, "(dddd)", fields))
+                return QRectF(fields[0], fields[1], fields[2], fields[3]);
             if (g_variant_n_children(value) == 4) {
                 return QRectF(
                             tupleValue<qreal>(value, 0),
@@ -148,6 +412,7 @@ QVariant MDConf::convertValue(GVariant *value, int typeHint)
                             tupleValue<qreal>(value, 3));
             }
             break;
+        }
         default:
             break;
         }
@@ -321,11 +586,33 @@ QVariant MDConf::read(DConfClient *client, const QByteArray &key, int typeHint)
     return value;
 }
 
-void MDConf::write(DConfClient *client, const QByteArray &key, const QVariant &value, bool synchronous)
+MDConf::LocalWrite::LocalWrite(DConfClient *client, QObject *origin)
+    : m_dispatcher(Dispatcher::get(client))
+    , m_previousOrigin(0)
+    , m_previousWriting(false)
+{
+    if (m_dispatcher) {
+        m_previousOrigin = m_dispatcher->origin;
+        m_previousWriting = m_dispatcher->writing;
+        m_dispatcher->origin = origin;
+        m_dispatcher->writing = true;
+    }
+}
+
+MDConf::LocalWrite::~LocalWrite()
+{
+    if (m_dispatcher) {
+        m_dispatcher->origin = m_previousOrigin;
+        m_dispatcher->writing = m_previousWriting;
+    }
+}
+
+void MDConf::write(DConfClient *client, const QByteArray &key, const QVariant &value, bool synchronous, QObject *origin)
 {
     GError *error = 0;
     GVariant *gvariant = 0;
     if (convertValue(value, &gvariant)) {
+        LocalWrite localWrite(client, origin);
         if (synchronous)
             dconf_client_write_sync(client, key, gvariant, 0, 0, &error);
         else
@@ -341,14 +628,60 @@ void MDConf::write(DConfClient *client, const QByteArray &key, const QVariant &v
     }
 }
 
-void MDConf::clear(DConfClient *client, const QByteArray &key, bool synchronous)
+void MDConf::clear(DConfClient *client, const QByteArray &key, bool synchronous, QObject *origin)
 {
+    LocalWrite localWrite(client, origin);
     if (synchronous)
         dconf_client_write_sync(client, key.constData(), 0, 0, 0, 0);
     else
         dconf_client_write_fast(client, key.constData(), 0, 0);
 }
 
+bool MDConf::set(DConfChangeset *changeset, const QByteArray &key, const QVariant &value)
+{
+    GVariant *gvariant = 0;
+    if (convertValue(value, &gvariant)) {
+        dconf_changeset_set(changeset, key.constData(), gvariant);
+        return true;
+    } else {
+        qCWarning(lcMlite) << "MDConf: no conversion for" << key << value;
+        return false;
+    }
+}
+
+void MDConf::change(DConfClient *client, DConfChangeset *changeset, bool synchronous, QObject *origin)
+{
+    if (dconf_changeset_is_empty(changeset))
+        return;
+
+    GError *error = 0;
+    LocalWrite localWrite(client, origin);
+    if (synchronous)
+        dconf_client_change_sync(client, changeset, 0, 0, &error);
+    else
+        dconf_client_change_fast(client, changeset, &error);
+
+    if (error) {
+        qCWarning(lcMlite) << "MDConf: Failed to write changes";
+        qCWarning(lcMlite) << error->message;
+        g_error_free(error);
+    }
+}
+
+void MDConf::writeMany(
+        DConfClient *client,
+        const QList<QPair<QByteArray, QVariant> > &values,
+        bool synchronous,
+        QObject *origin)
+{
+    DConfChangeset *changeset = dconf_changeset_new();
+    for (const QPair<QByteArray, QVariant> &value : values)
+        set(changeset, value.first, value.second);
+
+    change(client, changeset, synchronous, origin);
+    dconf_changeset_unref(changeset);
+}
+
 void MDConf::watch(DConfClient *client, const QByteArray &key, bool synchronous)
 {
     if (synchronous)
@@ -372,5 +705,32 @@ void MDConf::sync(DConfClient *client)
 
 DConfClient *MDConf::client()
 {
-    return dconf_client_new();
+    // Cleared by GObject when the last reference to the client is released.
+    static thread_local DConfClient *sharedClient = 0;
+
+    if (sharedClient) {
+        g_object_ref(sharedClient);
+    } else {
+        sharedClient = dconf_client_new();
+        g_object_add_weak_pointer(G_OBJECT(sharedClient), reinterpret_cast<gpointer *>(&sharedClient));
+        g_object_set_data_full(
+                    G_OBJECT(sharedClient),
+                    "mlite-dispatcher",
+                    new Dispatcher(sharedClient),
+                    Dispatcher::destroy);
+    }
+
+    return sharedClient;
+}
+
+void MDConf::subscribe(DConfClient *client, const QByteArray &path, QObject *receiver)
+{
+    if (Dispatcher *dispatcher = Dispatcher::get(client))
+        dispatcher->router.insert(path, receiver);
+}
+
+void MDConf::unsubscribe(DConfClient *client, const QByteArray &path, QObject *receiver)
+{
+    if (Dispatcher *dispatcher = Dispatcher::get(client))
+        dispatcher->router.remove(path, receiver);
 }
@@ -11,6 +11,7 @@
 
 #include <dconf/dconf.h>
 
+#include <mlite-global.h>
 #include <QVariant>
 #include <QEvent>
 
@@ -21,28 +22,66 @@ namespace MDConf
     public:
         enum { TYPE = QEvent::User };
 
-        Event(const char *aPrefix, GStrv aChanges) : QEvent((Type)TYPE),
-            prefix(aPrefix), changes(aChanges) {}
+        Event(const char *aPrefix, const gchar * const *aChanges) : QEvent((Type)TYPE),
+            prefix(g_strdup(aPrefix)), changes(g_strdupv(const_cast<gchar **>(aChanges))) {}
+        ~Event() { g_free(prefix); g_strfreev(changes); }
 
-        const char *prefix;
+        gchar *prefix;
         GStrv changes;
     };
 
+    class Dispatcher;
+
+    // Marks writes made while in scope as originating from a subscriber. The originating
+    // subscriber is notified of the resulting changes immediately, other subscribers of the
+    // same client are notified once the event loop runs.
+    class LocalWrite
+    {
+    public:
+        LocalWrite(DConfClient *client, QObject *origin);
+        ~LocalWrite();
+
+    private:
+        Q_DISABLE_COPY(LocalWrite)
+        Dispatcher *m_dispatcher;
+        QObject *m_previousOrigin;
+        bool m_previousWriting;
+    };
 
-QVariant convertValue(GVariant *value, int typeHint = QMetaType::UnknownType);
-bool convertValue(const QVariant &variant, GVariant **valp);
 
-QVariant read(DConfClient *client, const QByteArray &key, int typeHint = QMetaType::UnknownType);
+// The entry points marked MLITESHARED_EXPORT are also used by the benchmarks.
+MLITESHARED_EXPORT QVariant convertValue(GVariant *value, int typeHint = QMetaType::UnknownType);
+MLITESHARED_EXPORT bool convertValue(const QVariant &variant, GVariant **valp);
 
-void write(DConfClient *client, const QByteArray &key, const QVariant &value, bool synchronous = false);
+MLITESHARED_EXPORT QVariant read(DConfClient *client, const QByteArray &key, int typeHint = QMetaType::UnknownType);
 
-void clear(DConfClient *client, const QByteArray &key, bool synchronous = false);
+MLITESHARED_EXPORT void write(DConfClient *client, const QByteArray &key, const QVariant &value, bool synchronous = false, QObject *origin = 0);
+
+MLITESHARED_EXPORT void clear(DConfClient *client, const QByteArray &key, bool synchronous = false, QObject *origin = 0);
+
+// Adds a value for key to changeset, an invalid value resets the key.
+bool set(DConfChangeset *changeset, const QByteArray &key, const QVariant &value);
+// Applies all the changes in changeset as a single atomic write.
+void change(DConfClient *client, DConfChangeset *changeset, bool synchronous = false, QObject *origin = 0);
+
+void writeMany(
+        DConfClient *client,
+        const QList<QPair<QByteArray, QVariant> > &values,
+        bool synchronous = false,
+        QObject *origin = 0);
 
 void watch(DConfClient *client, const QByteArray &key, bool synchronous = false);
 void unwatch(DConfClient *client, const QByteArray &key, bool synchronous = false);
 
-void sync(DConfClient *client);
+MLITESHARED_EXPORT void sync(DConfClient *client);
+
+// Returns a new reference to the client shared by all users in the calling thread.
+MLITESHARED_EXPORT DConfClient *client();
 
-DConfClient *client();
+// Routes change notifications for path from a client obtained from client() to receiver as an
+// MDConf::Event. The path is either a key, or a directory ending in '/' in which case changes to
+// keys directly within the directory and resets of the directory or its parents are routed.
+void subscribe(DConfClient *client, const QByteArray &path, QObject *receiver);
+void unsubscribe(DConfClient *client, const QByteArray &path, QObject *receiver);
 
 }
@@ -11,10 +11,11 @@
 
 #include "mdconf_p.h"
 #include "mdconfgroup.h"
+#include "logging.h"
 
+#include <QBitArray>
 #include <QDebug>
 #include <QMetaProperty>
-#include <QCoreApplication>
 
 class MDConfGroupPrivate : public QObject
 {
@@ -23,14 +24,20 @@ public:
         : group(0)
         , scope(0)
         , client(0)
+        , changeset(0)
         , notifyIndex(-1)
         , propertyOffset(-1)
-        , signalId(-1)
+        , batchDepth(0)
+        , deferredReads(0)
+        , lateReads(0)
         , synchronous(false)
+        , lazy(false)
     {
     }
 
-    void readValue(const QMetaProperty &property);
+    void readValue(const QMetaProperty &property) const;
+    void write(const QByteArray &key, const QVariant &value);
+    void commitChanges();
 
     void resolveProperties(const QByteArray &scopePath);
     void cancelNotifications();
@@ -38,23 +45,28 @@ public:
     void connectToClient();
     void disconnectFromClient();
 
-    void notify(const QByteArray &basePath, const QByteArray &key);
-    static void changed(DConfClient *, gchar *prefix, GStrv changes, gchar *, gpointer user_data);
+    void notify(const QByteArray &key);
     void notify(const char *prefix, GStrv changes);
     void customEvent(QEvent* event);
 
     QByteArray absolutePath;
     QString path;
+    // Updated by reads of lazily bound properties from const accessors.
+    mutable QBitArray resolved;
     QList<MDConfGroup *> children;
     MDConfGroup *group;
     MDConfGroup *scope;
 
     DConfClient *client;
+    DConfChangeset *changeset;
 
-    int notifyIndex;
+    mutable int notifyIndex;
     int propertyOffset;
-    int signalId;
+    int batchDepth;
+    int deferredReads;
+    mutable int lateReads;
     bool synchronous;
+    bool lazy;
 };
 
 MDConfGroup::MDConfGroup(QObject *parent, BindOption option)
@@ -62,6 +74,7 @@ MDConfGroup::MDConfGroup(QObject *parent, BindOption option)
     , priv(new MDConfGroupPrivate)
 {
     priv->group = this;
+    priv->lazy = option == BindPropertiesLazily;
     if (option == DontBindProperties)
         resolveMetaObject(metaObject()->propertyCount());
 }
@@ -72,19 +85,28 @@ MDConfGroup::MDConfGroup(const QString &path, QObject *parent, BindOption option
 {
     priv->group = this;
     priv->path = path;
+    priv->lazy = option == BindPropertiesLazily;
     if (option == DontBindProperties)
         resolveMetaObject(metaObject()->propertyCount());
 }
 
 MDConfGroup::~MDConfGroup()
 {
+    priv->commitChanges();
+
+    if (priv->lazy) {
+        qCDebug(lcMlite) << "MDConfGroup" << priv->path << "avoided"
+                         << priv->deferredReads - priv->lateReads << "of"
+                         << priv->deferredReads << "deferred property reads";
+    }
+
     if (priv->client) {
         priv->cancelNotifications();
 
         foreach (MDConfGroup *child, priv->children)
             child->priv->scope = 0;
 
-        // If an absolute path disconnect the signal handler and unref, otherwise just unref.
+        // If an absolute path sync and unref, otherwise just unref.
         if (priv->path.startsWith(QLatin1Char('/')))
             priv->disconnectFromClient();
         else
@@ -138,6 +160,19 @@ void MDConfGroup::resolveMetaObject(int propertyOffset)
     }
 }
 
+void MDConfGroup::resolveProperty(int propertyIndex) const
+{
+    if (!priv->lazy
+            || priv->absolutePath.isEmpty()
+            || propertyIndex < priv->propertyOffset
+            || propertyIndex >= priv->resolved.size()
+            || priv->resolved.testBit(propertyIndex)) {
+        return;
+    }
+
+    priv->readValue(metaObject()->property(propertyIndex));
+}
+
 QString MDConfGroup::path() const
 {
     return priv->path;
@@ -249,6 +284,16 @@ QVariant MDConfGroup::value(const QString &key, const QVariant &defaultValue, in
     const QByteArray absoluteKey = !key.startsWith(QLatin1Char('/'))
             ? priv->absolutePath + key.toUtf8()
             : key.toUtf8();
+
+    // Values written in an uncommitted batch take precedence over stored values.
+    GVariant *pending = 0;
+    if (priv->changeset && dconf_changeset_get(priv->changeset, absoluteKey.constData(), &pending)) {
+        const QVariant value = MDConf::convertValue(pending, typeHint);
+        if (pending)
+            g_variant_unref(pending);
+        return value.isValid() ? value : defaultValue;
+    }
+
     const QVariant value = MDConf::read(priv->client, absoluteKey, typeHint);
     return value.isValid() ? value : defaultValue;
 }
@@ -261,13 +306,29 @@ void MDConfGroup::setValue(const QString &key, const QVariant &value)
     const QByteArray absoluteKey = !key.startsWith(QLatin1Char('/'))
             ? priv->absolutePath + key.toUtf8()
             : key.toUtf8();
-    MDConf::write(priv->client, absoluteKey, value, priv->synchronous);
+    priv->write(absoluteKey, value);
+}
+
+void MDConfGroup::beginBatch()
+{
+    ++priv->batchDepth;
+}
+
+void MDConfGroup::commit()
+{
+    if (priv->batchDepth > 0 && --priv->batchDepth == 0)
+        priv->commitChanges();
 }
 
 void MDConfGroup::clear()
 {
-    if (priv->client)
-        MDConf::clear(priv->client, priv->absolutePath, priv->synchronous);
+    if (!priv->client)
+        return;
+
+    if (priv->batchDepth > 0)
+        priv->write(priv->absolutePath, QVariant());
+    else
+        MDConf::clear(priv->client, priv->absolutePath, priv->synchronous, priv.data());
 }
 
 void MDConfGroup::sync()
@@ -288,11 +349,10 @@ void MDConfGroup::propertyChanged()
     for (int i = priv->propertyOffset; i < metaObject->propertyCount(); ++i) {
         const QMetaProperty property = metaObject->property(i);
         if (property.notifySignalIndex() == notifyIndex) {
-            MDConf::write(
-                        priv->client,
-                        priv->absolutePath + property.name(),
-                        property.read(this),
-                        priv->synchronous);
+            // The local value supersedes any deferred read.
+            if (i < priv->resolved.size())
+                priv->resolved.setBit(i);
+            priv->write(priv->absolutePath + property.name(), property.read(this));
         }
     }
 }
@@ -301,21 +361,53 @@ void MDConfGroupPrivate::connectToClient()
 {
     Q_ASSERT(!client);
     client = MDConf::client();
-    signalId = g_signal_connect(client, "changed", G_CALLBACK(changed), this);
 }
 
 void MDConfGroupPrivate::disconnectFromClient()
 {
     Q_ASSERT(client);
-    g_signal_handler_disconnect(client, signalId);
     if (!synchronous)
         MDConf::sync(client);
     g_object_unref(client);
     client = 0;
 }
 
-void MDConfGroupPrivate::readValue(const QMetaProperty &property)
+void MDConfGroupPrivate::write(const QByteArray &key, const QVariant &value)
+{
+    if (batchDepth == 0) {
+        MDConf::write(client, key, value, synchronous, this);
+        return;
+    }
+
+    if (!changeset)
+        changeset = dconf_changeset_new();
+    MDConf::set(changeset, key, value);
+}
+
+void MDConfGroupPrivate::commitChanges()
+{
+    if (!changeset)
+        return;
+
+    if (client)
+        MDConf::change(client, changeset, synchronous, this);
+    else
+        qCWarning(lcMlite) << "MDConfGroup: Discarding changes made without a valid path" << path;
+
+    dconf_changeset_unref(changeset);
+    changeset = 0;
+}
+
+void MDConfGroupPrivate::readValue(const QMetaProperty &property) const
 {
+    // Mark the property resolved first as writing it may call back into its read accessor.
+    const int propertyIndex = property.propertyIndex();
+    if (propertyIndex < resolved.size() && !resolved.testBit(propertyIndex)) {
+        resolved.setBit(propertyIndex);
+        if (lazy)
+            ++lateReads;
+    }
+
     const QVariant value = MDConf::read(client, absolutePath + property.name(), property.type());
     if (value.isValid()) {
         // Record the notify signal index so the propertyChanged() slot knows the change
@@ -342,11 +434,16 @@ void MDConfGroupPrivate::resolveProperties(const QByteArray &scopePath)
     absolutePath = scopePath + path.toUtf8() + '/';
 
     // Iterate over the object's properties and read the corresponding values from dconf
-    // and write them to the property.
+    // and write them to the property, or if lazily bound defer that until they are accessed.
     const QMetaObject * const metaObject = group->metaObject();
-    for (int i = propertyOffset; i < metaObject->propertyCount(); ++i)
+    resolved.fill(false, metaObject->propertyCount());
+    if (lazy) {
+        deferredReads += metaObject->propertyCount() - propertyOffset;
+    } else for (int i = propertyOffset; i < metaObject->propertyCount(); ++i) {
         readValue(metaObject->property(i));
+    }
 
+    MDConf::subscribe(client, absolutePath, this);
     MDConf::watch(client, absolutePath, synchronous);
 
     // Recurse into children with relative paths and resolve their properties as well.
@@ -363,6 +460,7 @@ void MDConfGroupPrivate::resolveProperties(const QByteArray &scopePath)
 void MDConfGroupPrivate::cancelNotifications()
 {
     if (!absolutePath.isEmpty()) {
+        MDConf::unsubscribe(client, absolutePath, this);
         MDConf::unwatch(client, absolutePath, synchronous);
         absolutePath = QByteArray();
 
@@ -378,47 +476,40 @@ void MDConfGroupPrivate::cancelNotifications()
     }
 }
 
-void MDConfGroupPrivate::notify(const QByteArray &basePath, const QByteArray &key)
+void MDConfGroupPrivate::notify(const QByteArray &key)
 {
-    // If the notification is for this group read the new value for a specify property or
-    // if key is empty all properties.  Otherwise pass the notification onto any child groups
-    // whose absolute path is prefix of the notification path.
-    if (basePath.length() == absolutePath.length()) {
-        const QMetaObject *const metaObject = group->metaObject();
-        if (!key.isEmpty()) {
-            const int propertyIndex = metaObject->indexOfProperty(key);
-            if (propertyIndex >= propertyOffset)
-                readValue(metaObject->property(propertyIndex));
-            emit group->valueChanged(QString::fromUtf8(key));
-        } else {
-            for (int i = propertyOffset; i < metaObject->propertyCount(); ++i)
-                readValue(metaObject->property(i));
-            emit group->valuesChanged();
-        }
-    } else for (int i = 0; i < children.count(); ++i) {
-        MDConfGroup * const child = children.at(i);
-        if (!child->priv->path.startsWith(QLatin1Char('/'))
-                && basePath.startsWith(child->priv->absolutePath)) {
-            child->priv->notify(basePath, key);
-        }
+    // Read the new value for a specific property or if key is empty all properties.
+    const QMetaObject *const metaObject = group->metaObject();
+    if (!key.isEmpty()) {
+        const int propertyIndex = metaObject->indexOfProperty(key);
+        if (propertyIndex >= propertyOffset)
+            readValue(metaObject->property(propertyIndex));
+        emit group->valueChanged(QString::fromUtf8(key));
+    } else {
+        for (int i = propertyOffset; i < metaObject->propertyCount(); ++i)
+            readValue(metaObject->property(i));
+        emit group->valuesChanged();
     }
 }
 
 void MDConfGroupPrivate::notify(const char *prefix, GStrv changes)
 {
+    // Every group is subscribed to its own absolute path so child groups are notified directly,
+    // a notification may still batch changes for other paths though.
     const QByteArray prefixPath = QByteArray(prefix);
-    // Early exit if the notification is not relevant to this group.
-    if (!prefixPath.startsWith(absolutePath) && !absolutePath.startsWith(prefixPath))
-        return;
-
-    // Construct the group path and key for each change and perform updates.
-    for (int i = 0; changes[i]; ++i) {
+    for (int i = 0; changes[i] && !absolutePath.isEmpty(); ++i) {
         const QByteArray absoluteKey = prefixPath + QByteArray(changes[i]);
-        const int pathLength = absoluteKey.lastIndexOf('/') + 1;
-        const QByteArray basePath = absoluteKey.mid(0, pathLength);
-        const QByteArray key = absoluteKey.mid(pathLength);
 
-        notify(basePath, key);
+        if (absoluteKey.endsWith('/')) {
+            // A reset of this group's directory or one of its parents.
+            if (absolutePath.startsWith(absoluteKey)) {
+                notify(QByteArray());
+                return;
+            }
+        } else if (absoluteKey.lastIndexOf('/') + 1 == absolutePath.length()
+                && absoluteKey.startsWith(absolutePath)) {
+            notify(absoluteKey.mid(absolutePath.length()));
+        }
     }
 }
 
@@ -429,9 +520,3 @@ void MDConfGroupPrivate::customEvent(QEvent* event)
         notify(dconfEvent->prefix, dconfEvent->changes);
     }
 }
-
-void MDConfGroupPrivate::changed(DConfClient *, gchar *prefix, GStrv changes, gchar *, gpointer data)
-{
-    MDConf::Event event(prefix, changes);
-    QCoreApplication::sendEvent((MDConfGroupPrivate*)data, &event);
-}
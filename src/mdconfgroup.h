@@ -78,11 +78,16 @@ public:
         \value BindProperties MDConfGroup will bind to properties of the
         derived type.  Note you must call resolveMetaObject to complete
         initialization of a MDConfGroup when using this option.
+        \value BindPropertiesLazily MDConfGroup will bind to properties of the
+        derived type but will not read their values from DConf until they are
+        first accessed or a change is notified.  Property read accessors of the
+        derived type must call resolveProperty() when using this option.
      */
     enum BindOption
     {
         DontBindProperties,
-        BindProperties
+        BindProperties,
+        BindPropertiesLazily
     };
 
     /*!
@@ -184,6 +189,26 @@ public:
     */
     Q_INVOKABLE void setValue(const QString &key, const QVariant &value);
 
+    /*!
+        Begins a batch of writes.
+
+        Until commit() is called values written by this group with \l setValue(),
+        bound property changes and \l clear() are collected rather than written
+        to DConf, and \l value() returns the collected values.  Batches may be
+        nested, the changes are only written once the outermost batch is
+        committed.
+    */
+    Q_INVOKABLE void beginBatch();
+
+    /*!
+        Ends a batch of writes started with beginBatch().
+
+        All changes collected since the outermost beginBatch() are written to
+        DConf as a single atomic change, resulting in a single notification.
+        Any pending changes are also committed if the group is destroyed.
+    */
+    Q_INVOKABLE void commit();
+
 public slots:
     /*!
         Syncs and pending writes to DConf.
@@ -219,6 +244,16 @@ protected:
      */
     void resolveMetaObject(int propertyOffset = -1);
 
+    /*!
+        Reads the value of the bound property with the given \a propertyIndex
+        from DConf if it has not been read since the group's path was resolved.
+
+        Types constructed with the BindPropertiesLazily option should call this
+        from the read accessor of each bound property before returning its
+        value.  It has no effect for other types.
+    */
+    void resolveProperty(int propertyIndex) const;
+
 private slots:
     void propertyChanged();
 
@@ -20,12 +20,23 @@
 #include <QFile>
 #include <QStringList>
 #include <QLocale>
+#include <QMutex>
+#include <QSet>
 #include <QTextStream>
-#include <QTimer>
+#include <QAtomicInt>
+#include <QScopedPointer>
+#include <QSemaphore>
+#include <QThreadPool>
 #include <QTranslator>
+#include <QVarLengthArray>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
 
 #include "mdesktopentry.h"
 #include "mdesktopentry_p.h"
+#include "mtranslations_p.h"
 #include "logging.h"
 
 namespace {
@@ -50,6 +61,7 @@ const QString StartupNotifyKey("StartupNotify");
 const QString StartupWMClassKey("StartupWMClass");
 const QString URLKey("URL");
 const QString TranslationIdTemplate("X-Amber-Translation-Id-%1");
+const QString TranslationIdPrefix("X-Amber-Translation-Id-");
 const QString TranslationCatalogKey("X-Amber-Translation-Catalog");
 const QString LegacyTranslationIdKey("X-MeeGo-Logical-Id");
 const QString LegacyTranslationCatalogKey("X-MeeGo-Translation-Catalog");
@@ -57,170 +69,679 @@ const QString XMaemoServiceKey("X-Maemo-Service");
 const QString SailjailSection("X-Sailjail");
 const QString SandboxingKey("Sandboxing");
 const QString DisabledValue("Disabled");
-const int TranslatorLifetime = 100;
+const uint HashSeed = 2166136261u;
+const uint HashPrime = 16777619u;
+
+inline bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+inline uint hashBytes(uint hash, const char *data, int length)
+{
+    for (int i = 0; i < length; ++i) {
+        hash ^= uchar(data[i]);
+        hash *= HashPrime;
+    }
+    return hash;
 }
 
-GKeyFileWrapper::GKeyFileWrapper()
-    : m_key_file(g_key_file_new())
+inline bool isAscii(const QChar *chars, int length)
 {
+    for (int i = 0; i < length; ++i) {
+        if (chars[i].unicode() >= 0x80)
+            return false;
+    }
+    return true;
 }
 
-GKeyFileWrapper::~GKeyFileWrapper()
+// Hashes the UTF-8 representation of chars, without converting the common ASCII case.
+uint hashChars(uint hash, const QChar *chars, int length)
 {
-    g_key_file_free(m_key_file);
+    if (!isAscii(chars, length)) {
+        const QByteArray utf8 = QString(chars, length).toUtf8();
+        return hashBytes(hash, utf8.constData(), utf8.size());
+    }
+
+    for (int i = 0; i < length; ++i) {
+        hash ^= chars[i].unicode();
+        hash *= HashPrime;
+    }
+    return hash;
+}
+
+bool equals(const char *data, int length, const QChar *chars, int charCount)
+{
+    if (!isAscii(chars, charCount))
+        return QString(chars, charCount).toUtf8() == QByteArray::fromRawData(data, length);
+
+    if (length != charCount)
+        return false;
+
+    for (int i = 0; i < length; ++i) {
+        if (uchar(data[i]) != chars[i].unicode())
+            return false;
+    }
+    return true;
 }
 
-bool GKeyFileWrapper::load(QIODevice &device)
+// Validates a key like g_key_file_is_key_name(), baseLength is the length without the locale.
+bool isKeyName(const char *data, int length, int *baseLength)
 {
-    QByteArray contents = device.readAll();
+    int i = 0;
+    while (i < length && data[i] != '=' && data[i] != '[' && data[i] != ']')
+        ++i;
 
-    GError *err = NULL;
-    if (!g_key_file_load_from_data(m_key_file, contents.constData(), contents.size(), G_KEY_FILE_NONE, &err)) {
-        qCWarning(lcMlite) << "Could not load .desktop file:" << QString::fromUtf8(err->message);
-        g_clear_error(&err);
+    if (i == 0 || data[0] == ' ' || data[i - 1] == ' ')
         return false;
+
+    *baseLength = i;
+
+    if (i < length && data[i] == '[') {
+        for (++i; i < length; ++i) {
+            const char c = data[i];
+            if (!(c >= 'a' && c <= 'z') && !(c >= 'A' && c <= 'Z') && !(c >= '0' && c <= '9')
+                    && c != '-' && c != '_' && c != '.' && c != '@' && uchar(c) < 0x80) {
+                break;
+            }
+        }
+        if (i == length || data[i] != ']')
+            return false;
+        ++i;
     }
 
+    return i == length;
+}
+
+bool isGroupName(const char *data, int length)
+{
+    if (length == 0)
+        return false;
+
+    for (int i = 0; i < length; ++i) {
+        const uchar c = data[i];
+        if (c == '[' || c == ']' || c < 0x20 || c == 0x7f)
+            return false;
+    }
     return true;
 }
 
-QString GKeyFileWrapper::startGroup() const
+// Appends the variants of a language[_territory][.codeset][@modifier] locale, most specific first.
+void appendLocaleVariants(QList<QByteArray> *names, const QByteArray &locale)
 {
-    QString result;
+    enum { Codeset = 1 << 0, Territory = 1 << 1, Modifier = 1 << 2 };
+
+    const int territoryIndex = locale.indexOf('_');
+    const int codesetIndex = locale.indexOf('.', qMax(territoryIndex, 0));
+    const int modifierIndex = locale.indexOf('@', qMax(qMax(codesetIndex, territoryIndex), 0));
+
+    int end = locale.size();
+    QByteArray modifier;
+    QByteArray codeset;
+    QByteArray territory;
+    int mask = 0;
+    if (modifierIndex >= 0) {
+        modifier = locale.mid(modifierIndex, end - modifierIndex);
+        end = modifierIndex;
+        mask |= Modifier;
+    }
+    if (codesetIndex >= 0) {
+        codeset = locale.mid(codesetIndex, end - codesetIndex);
+        end = codesetIndex;
+        mask |= Codeset;
+    }
+    if (territoryIndex >= 0) {
+        territory = locale.mid(territoryIndex, end - territoryIndex);
+        end = territoryIndex;
+        mask |= Territory;
+    }
+    const QByteArray language = locale.left(end);
+
+    for (int i = mask; i >= 0; --i) {
+        if ((i & ~mask) == 0) {
+            QByteArray variant = language;
+            if (i & Territory)
+                variant += territory;
+            if (i & Codeset)
+                variant += codeset;
+            if (i & Modifier)
+                variant += modifier;
+            names->append(variant);
+        }
+    }
+}
 
-    gchar *section = g_key_file_get_start_group(m_key_file);
-    result = QString::fromUtf8(section);
-    g_free(section);
+// The languages in the order g_get_language_names() returns them.
+const QList<QByteArray> &languageNames()
+{
+    thread_local QByteArray cachedLocale;
+    thread_local QList<QByteArray> cachedNames;
+
+    const QByteArray locale = MTranslations::localeEnvironment();
+    if (cachedNames.isEmpty() || locale != cachedLocale) {
+        cachedLocale = locale;
+        cachedNames.clear();
+        for (const QByteArray &name : locale.split(':')) {
+            if (!name.isEmpty() && name != "C")
+                appendLocaleVariants(&cachedNames, name);
+        }
+        cachedNames.append("C");
+    }
 
-    return result;
+    return cachedNames;
 }
 
-QStringList GKeyFileWrapper::sections() const
+// Returns a shared copy of a string from a small vocabulary, like categories and MIME types.
+QString internString(const QString &string)
 {
-    QStringList result;
+    const int MaximumInternedStrings = 4096;
+    static QMutex mutex;
+    static QSet<QString> strings;
+
+    QMutexLocker locker(&mutex);
+    QSet<QString>::const_iterator it = strings.constFind(string);
+    if (it != strings.constEnd())
+        return *it;
+    if (strings.count() < MaximumInternedStrings)
+        strings.insert(string);
+    return string;
+}
+
+class DesktopEntryLoader : public QRunnable
+{
+public:
+    DesktopEntryLoader(const std::function<void()> &load, QSemaphore *finished)
+        : m_load(load)
+        , m_finished(finished)
+    {
+    }
 
-    gchar **sections = g_key_file_get_groups(m_key_file, NULL);
-    gchar **section = sections;
-    while (*section) {
-        result << QString::fromUtf8(*section++);
+    void run()
+    {
+        m_load();
+        m_finished->release();
     }
-    g_strfreev(sections);
 
-    return result;
+private:
+    std::function<void()> m_load;
+    QSemaphore *m_finished;
+};
+
+// An invalid entry without a file, shared by default constructed and moved-from entries. Holds a reference of its own,
+// so it's never deleted.
+MDesktopEntryPrivate *sharedNullPrivate()
+{
+    static MDesktopEntryPrivate *const null = [] {
+        MDesktopEntryPrivate *d = new MDesktopEntryPrivate(QString(), false);
+        d->ref.ref();
+        return d;
+    }();
+    return null;
+}
 }
 
-QStringList GKeyFileWrapper::keys(const QString &section) const
+KeyFile::KeyFile()
 {
-    QStringList result;
-    QByteArray section_utf8 = section.toUtf8();
+}
 
-    GError *err = NULL;
+bool KeyFile::load(QIODevice &device)
+{
+    m_data = device.readAll();
+    m_sections.clear();
+    m_entries.clear();
+    m_index.clear();
+
+    if (!parse()) {
+        m_data.clear();
+        m_sections.clear();
+        m_entries.clear();
+        m_index.clear();
+        return false;
+    }
 
-    gchar **keys = g_key_file_get_keys(m_key_file, section_utf8.constData(), NULL, &err);
-    if (keys == NULL) {
-        qCWarning(lcMlite) << "Could not get keys:" << QString::fromUtf8(err->message);
-        g_clear_error(&err);
-        return result;
+    return true;
+}
+
+bool KeyFile::parse()
+{
+    const char *const data = m_data.constData();
+    const int size = m_data.size();
+    int section = -1;
+
+    for (int lineStart = 0, lineNumber = 1; lineStart < size; ++lineNumber) {
+        const char *newline = static_cast<const char *>(memchr(data + lineStart, '\n', size - lineStart));
+        const int end = newline ? int(newline - data) : size;
+
+        Span name;
+        Span value;
+        int baseLength = 0;
+        switch (parseLine(data, lineStart, end, lineNumber, &name, &baseLength, &value)) {
+        case BlankLine:
+            break;
+        case GroupLine:
+            section = addSection(name);
+            break;
+        case EntryLine:
+            if (section < 0) {
+                qCWarning(lcMlite) << "Could not load .desktop file: Key file does not start with a group";
+                return false;
+            }
+            addEntry(section, name, baseLength, value);
+            break;
+        case InvalidLine:
+            return false;
+        }
+
+        lineStart = end + 1;
+    }
+
+    return true;
+}
+
+KeyFile::LineType KeyFile::parseLine(const char *data, int start, int end, int lineNumber,
+                                     Span *name, int *baseLength, Span *value)
+{
+    if (end > start && data[end - 1] == '\r')
+        --end;
+    while (start < end && isSpace(data[start]))
+        ++start;
+
+    if (start == end || data[start] == '#')
+        return BlankLine;
+
+    if (data[start] == '[') {
+        const char *close = static_cast<const char *>(memchr(data + start, ']', end - start));
+        int trailing = close ? int(close - data) + 1 : end;
+        while (trailing < end && (data[trailing] == ' ' || data[trailing] == '\t'))
+            ++trailing;
+
+        if (close && trailing == end) {
+            name->offset = start + 1;
+            name->length = int(close - data) - start - 1;
+            if (!isGroupName(data + name->offset, name->length)) {
+                qCWarning(lcMlite) << "Could not load .desktop file: Invalid group name on line" << lineNumber;
+                return InvalidLine;
+            }
+            return GroupLine;
+        }
     }
 
-    gchar **key = keys;
-    while (*key) {
-        result << QString::fromUtf8(*key++);
+    const char *separator = static_cast<const char *>(memchr(data + start, '=', end - start));
+    if (!separator || separator == data + start) {
+        qCWarning(lcMlite) << "Could not load .desktop file: Line" << lineNumber
+                           << "is not a key-value pair, group, or comment";
+        return InvalidLine;
     }
-    g_strfreev(keys);
 
-    return result;
+    int keyEnd = int(separator - data);
+    while (keyEnd > start && isSpace(data[keyEnd - 1]))
+        --keyEnd;
+
+    if (!isKeyName(data + start, keyEnd - start, baseLength)) {
+        qCWarning(lcMlite) << "Could not load .desktop file: Invalid key name on line" << lineNumber;
+        return InvalidLine;
+    }
+
+    int valueStart = int(separator - data) + 1;
+    while (valueStart < end && isSpace(data[valueStart]))
+        ++valueStart;
+
+    name->offset = start;
+    name->length = keyEnd - start;
+    value->offset = valueStart;
+    value->length = end - valueStart;
+    return EntryLine;
 }
 
-QString GKeyFileWrapper::localizedValue(const QString &section, const QString &key) const
+KeyFile::Span KeyFile::append(const char *string)
 {
-    QString result;
+    const Span span = { m_data.size(), int(strlen(string)) };
+    m_data.append(string, span.length);
+    return span;
+}
 
-    QByteArray section_utf8 = section.toUtf8();
-    QByteArray key_utf8 = key.toUtf8();
+int KeyFile::addSection(const Span &name)
+{
+    const char *const data = m_data.constData();
+    const uint hash = hashBytes(HashSeed, data + name.offset, name.length);
+
+    // Like GKeyFile, a repeated group continues the earlier one.
+    for (int i = 0; i < m_sections.count(); ++i) {
+        const Section &section = m_sections.at(i);
+        if (section.hash == hash
+                && section.name.length == name.length
+                && memcmp(data + section.name.offset, data + name.offset, name.length) == 0) {
+            return i;
+        }
+    }
 
-    GError *err = NULL;
-    gchar *value = g_key_file_get_locale_string(m_key_file, section_utf8.constData(), key_utf8.constData(), NULL, &err);
-    if (!value) {
-        qCWarning(lcMlite) << "Could not read value:" << QString::fromUtf8(err->message);
-        g_clear_error(&err);
-        return result;
+    const Section section = { name, hash };
+    m_sections.append(section);
+    return m_sections.count() - 1;
+}
+
+void KeyFile::addEntry(int section, const Span &key, int baseLength, const Span &value)
+{
+    const char *const data = m_data.constData();
+    const uint hash = hashBytes(m_sections.at(section).hash, data + key.offset, baseLength);
+
+    // A repeated key replaces the earlier value.
+    for (QMultiHash<uint, int>::const_iterator it = m_index.constFind(hash);
+            it != m_index.constEnd() && it.key() == hash; ++it) {
+        Entry &entry = m_entries[it.value()];
+        if (entry.section == section
+                && entry.key.length == key.length
+                && memcmp(data + entry.key.offset, data + key.offset, key.length) == 0) {
+            entry.value = value;
+            return;
+        }
     }
 
-    result = QString::fromUtf8(value);
-    g_free(value);
+    const Entry entry = { hash, section, key, baseLength, value };
+    m_index.insert(hash, m_entries.count());
+    m_entries.append(entry);
+}
 
-    return result;
+int KeyFile::findSection(const QString &section) const
+{
+    const char *const data = m_data.constData();
+    const uint hash = hashChars(HashSeed, section.constData(), section.size());
+
+    for (int i = 0; i < m_sections.count(); ++i) {
+        const Section &candidate = m_sections.at(i);
+        if (candidate.hash == hash
+                && equals(data + candidate.name.offset, candidate.name.length, section.constData(), section.size())) {
+            return i;
+        }
+    }
+    return -1;
 }
 
-QString GKeyFileWrapper::stringValue(const QString &section, const QString &key) const
+int KeyFile::find(const QString &section, const QString &key) const
 {
-    QString result;
+    const int sectionIndex = findSection(section);
+    if (sectionIndex < 0)
+        return -1;
+
+    const QChar *const chars = key.constData();
+    const int length = key.size();
+
+    int baseLength = length;
+    if (length > 0 && chars[length - 1] == QLatin1Char(']')) {
+        const int bracket = key.indexOf(QLatin1Char('['));
+        if (bracket >= 0)
+            baseLength = bracket;
+    }
+
+    const char *const data = m_data.constData();
+    const uint hash = hashChars(m_sections.at(sectionIndex).hash, chars, baseLength);
+
+    for (QMultiHash<uint, int>::const_iterator it = m_index.constFind(hash);
+            it != m_index.constEnd() && it.key() == hash; ++it) {
+        const Entry &entry = m_entries.at(it.value());
+        if (entry.section == sectionIndex
+                && equals(data + entry.key.offset, entry.key.length, chars, length)) {
+            return it.value();
+        }
+    }
+    return -1;
+}
+
+bool KeyFile::unescape(const Span &value, QString *string, QStringList *list) const
+{
+    return unescape(m_data.constData() + value.offset, value.length, string, list);
+}
+
+bool KeyFile::unescape(const char *data, int length, QString *string, QStringList *list)
+{
+    const char *p = data;
+    const char *const end = p + length;
+
+    if (!list && !memchr(p, '\\', length)) {
+        *string = QString::fromUtf8(p, length);
+        return true;
+    }
+
+    QByteArray buffer;
+    buffer.reserve(length);
+
+    for (; p < end; ++p) {
+        char c = *p;
+        if (c == '\\') {
+            if (++p == end) {
+                qCWarning(lcMlite) << "Could not read value: Key file contains escape character at end of line";
+                return false;
+            }
+
+            switch (*p) {
+            case 's':
+                c = ' ';
+                break;
+            case 'n':
+                c = '\n';
+                break;
+            case 't':
+                c = '\t';
+                break;
+            case 'r':
+                c = '\r';
+                break;
+            case '\\':
+                c = '\\';
+                break;
+            default:
+                if (!list || *p != ';') {
+                    qCWarning(lcMlite) << "Could not read value: Key file contains invalid escape sequence"
+                                       << QByteArray(p - 1, 2);
+                    return false;
+                }
+                c = ';';
+                break;
+            }
+        } else if (list && c == ';') {
+            list->append(QString::fromUtf8(buffer));
+            buffer.clear();
+            continue;
+        }
+        buffer.append(c);
+    }
+
+    if (!list)
+        *string = QString::fromUtf8(buffer);
+    else if (!buffer.isEmpty())
+        list->append(QString::fromUtf8(buffer));
+
+    return true;
+}
+
+QString KeyFile::startGroup() const
+{
+    return m_sections.isEmpty() ? QString() : QString::fromUtf8(
+                m_data.constData() + m_sections.first().name.offset, m_sections.first().name.length);
+}
 
-    QByteArray section_utf8 = section.toUtf8();
-    QByteArray key_utf8 = key.toUtf8();
+QStringList KeyFile::sections() const
+{
+    QStringList result;
+    for (const Section &section : m_sections)
+        result << QString::fromUtf8(m_data.constData() + section.name.offset, section.name.length);
+    return result;
+}
+
+QStringList KeyFile::keys(const QString &section) const
+{
+    QStringList result;
 
-    GError *err = NULL;
-    gchar *value = g_key_file_get_string(m_key_file, section_utf8.constData(), key_utf8.constData(), &err);
-    if (!value) {
-        qCWarning(lcMlite) << "Could not read value:" << QString::fromUtf8(err->message);
-        g_clear_error(&err);
+    const int sectionIndex = findSection(section);
+    if (sectionIndex < 0) {
+        qCWarning(lcMlite) << "Could not get keys: Key file does not have group" << section;
         return result;
     }
 
-    result = QString::fromUtf8(value);
-    g_free(value);
+    for (const Entry &entry : m_entries) {
+        if (entry.section == sectionIndex)
+            result << QString::fromUtf8(m_data.constData() + entry.key.offset, entry.key.length);
+    }
 
     return result;
 }
 
-bool GKeyFileWrapper::booleanValue(const QString &section, const QString &key) const
+QString KeyFile::localizedValue(const QString &section, const QString &key) const
 {
-    gboolean result = FALSE;
+    const int sectionIndex = findSection(section);
+    const QList<QByteArray> &languages = languageNames();
+
+    // Collect the untranslated value and the translations for the current languages, best first.
+    QVarLengthArray<QPair<int, int>, 8> candidates;
+    if (sectionIndex >= 0) {
+        const char *const data = m_data.constData();
+        const uint hash = hashChars(m_sections.at(sectionIndex).hash, key.constData(), key.size());
+
+        for (QMultiHash<uint, int>::const_iterator it = m_index.constFind(hash);
+                it != m_index.constEnd() && it.key() == hash; ++it) {
+            const int i = it.value();
+            const Entry &entry = m_entries.at(i);
+            if (entry.section != sectionIndex
+                    || !equals(data + entry.key.offset, entry.baseLength, key.constData(), key.size())) {
+                continue;
+            }
+
+            int rank = languages.count();
+            if (entry.key.length != entry.baseLength) {
+                rank = languages.indexOf(QByteArray::fromRawData(
+                        data + entry.key.offset + entry.baseLength + 1, entry.key.length - entry.baseLength - 2));
+                if (rank < 0)
+                    continue;
+            }
+            candidates.append(qMakePair(rank, i));
+        }
+        std::sort(candidates.begin(), candidates.end());
+    }
 
-    QByteArray section_utf8 = section.toUtf8();
-    QByteArray key_utf8 = key.toUtf8();
+    QString result;
+    for (const QPair<int, int> &candidate : candidates) {
+        if (unescape(m_entries.at(candidate.second).value, &result, 0))
+            return result;
+    }
+
+    if (candidates.isEmpty())
+        qCWarning(lcMlite) << "Could not read value: Key file does not have key" << key << "in group" << section;
+
+    return QString();
+}
+
+QString KeyFile::stringValue(const QString &section, const QString &key) const
+{
+    const int index = find(section, key);
+    if (index < 0) {
+        qCWarning(lcMlite) << "Could not read value: Key file does not have key" << key << "in group" << section;
+        return QString();
+    }
 
-    GError *err = NULL;
-    result = g_key_file_get_boolean(m_key_file, section_utf8.constData(), key_utf8.constData(), &err);
-    if (err != NULL) {
+    return stringValue(index);
+}
+
+bool KeyFile::booleanValue(const QString &section, const QString &key) const
+{
+    const int index = find(section, key);
+    if (index < 0) {
         qCWarning(lcMlite) << "Could not read boolean value for "
-                   << section << "/" << key << ":" << QString::fromUtf8(err->message);
-        g_clear_error(&err);
+                   << section << "/" << key << ": Key file does not have key";
+        return false;
     }
 
-    return result;
+    const Span &value = m_entries.at(index).value;
+    const char *const data = m_data.constData() + value.offset;
+    int length = value.length;
+    while (length > 0 && isSpace(data[length - 1]))
+        --length;
+
+    const QByteArray string = QByteArray::fromRawData(data, length);
+    if (string == "true" || string == "1")
+        return true;
+    if (string != "false" && string != "0") {
+        qCWarning(lcMlite) << "Could not read boolean value for "
+                   << section << "/" << key << ": Value" << string << "cannot be interpreted as a boolean";
+    }
+    return false;
 }
 
-QStringList GKeyFileWrapper::stringList(const QString &section, const QString &key) const
+QStringList KeyFile::stringList(const QString &section, const QString &key) const
 {
     QStringList result;
 
-    QByteArray section_utf8 = section.toUtf8();
-    QByteArray key_utf8 = key.toUtf8();
+    const int index = find(section, key);
+    if (index >= 0 && !unescape(m_entries.at(index).value, 0, &result))
+        result.clear();
 
-    gchar **values = g_key_file_get_string_list(m_key_file, section_utf8.constData(), key_utf8.constData(), NULL, NULL);
-    gchar **value = values;
-    while (value && *value) {
-        result << QString::fromUtf8(*value);
-        value++;
-    }
-    g_strfreev(values);
+    return result;
+}
+
+bool KeyFile::contains(const QString &section, const QString &key) const
+{
+    return find(section, key) >= 0;
+}
+
+bool KeyFile::hasSection(const QString &section) const
+{
+    return findSection(section) >= 0;
+}
+
+int KeyFile::count() const
+{
+    return m_entries.count();
+}
+
+QString KeyFile::section(int index) const
+{
+    const Span &name = m_sections.at(m_entries.at(index).section).name;
+    return QString::fromUtf8(m_data.constData() + name.offset, name.length);
+}
 
+QString KeyFile::key(int index) const
+{
+    const Span &key = m_entries.at(index).key;
+    return QString::fromUtf8(m_data.constData() + key.offset, key.length);
+}
+
+QString KeyFile::stringValue(int index) const
+{
+    QString result;
+    if (!unescape(m_entries.at(index).value, &result, 0))
+        result.clear();
     return result;
 }
 
-bool GKeyFileWrapper::contains(const QString &section, const QString &key) const
+QByteArray KeyFile::rawSection(int index) const
 {
-    QByteArray section_utf8 = section.toUtf8();
-    QByteArray key_utf8 = key.toUtf8();
-    return g_key_file_has_key(m_key_file, section_utf8, key_utf8, NULL);
+    const Span &name = m_sections.at(m_entries.at(index).section).name;
+    return QByteArray(m_data.constData() + name.offset, name.length);
 }
 
-bool GKeyFileWrapper::hasSection(const QString &section) const
+QByteArray KeyFile::rawKey(int index) const
 {
-    QByteArray section_utf8 = section.toUtf8();
-    return g_key_file_has_group(m_key_file, section_utf8);
+    const Span &key = m_entries.at(index).key;
+    return QByteArray(m_data.constData() + key.offset, key.length);
+}
+
+QByteArray KeyFile::rawValue(int index) const
+{
+    const Span &value = m_entries.at(index).value;
+    return QByteArray(m_data.constData() + value.offset, value.length);
+}
+
+void KeyFile::setRawValue(const char *section, const char *key, const char *value)
+{
+    int baseLength = 0;
+    if (!isKeyName(key, strlen(key), &baseLength) || !isGroupName(section, strlen(section))) {
+        qCWarning(lcMlite) << "Could not set value: Invalid group or key name" << section << key;
+        return;
+    }
+
+    const int sectionIndex = addSection(append(section));
+    const Span keySpan = append(key);
+    const Span valueSpan = append(value);
+    addEntry(sectionIndex, keySpan, baseLength, valueSpan);
 }
 
 
@@ -228,7 +749,8 @@ MDesktopEntryPrivate::MDesktopEntryPrivate(const QString &fileName)
     : sourceFileName(fileName)
     , keyFile()
     , valid(true)
-    , translatorUnavailable(false)
+    , fieldsDecoded(0)
+    , localizedGeneration(-1)
     , q_ptr(NULL)
 {
     QFile file(fileName);
@@ -246,44 +768,149 @@ MDesktopEntryPrivate::MDesktopEntryPrivate(const QString &fileName)
     }
 }
 
-MDesktopEntryPrivate::~MDesktopEntryPrivate()
+MDesktopEntryPrivate::MDesktopEntryPrivate(const QString &fileName, bool valid)
+    : sourceFileName(fileName)
+    , keyFile()
+    , valid(valid)
+    , fieldsDecoded(0)
+    , localizedGeneration(-1)
+    , q_ptr(NULL)
 {
 }
 
-QTranslator *MDesktopEntryPrivate::loadTranslator() const
+MDesktopEntryPrivate::~MDesktopEntryPrivate()
 {
-    if (translatorUnavailable)
-        return 0;
-
-    if (cachedTranslator)
-        return cachedTranslator.data();
+}
 
-    QTranslator *translator = new QTranslator;
+const MDesktopEntryPrivate::Fields &MDesktopEntryPrivate::fields() const
+{
+    if (fieldsDecoded.loadAcquire())
+        return decodedFields;
+
+    QMutexLocker locker(&cacheMutex);
+    if (fieldsDecoded.loadAcquire())
+        return decodedFields;
+
+    const auto stringField = [this](const QString &key, QString *field) {
+        const bool present = keyFile.contains(DesktopEntrySection, key);
+        if (present)
+            *field = keyFile.stringValue(DesktopEntrySection, key);
+        return present;
+    };
+    const auto listField = [this](const QString &key) {
+        QStringList list = keyFile.stringList(DesktopEntrySection, key);
+        for (QString &item : list)
+            item = internString(item);
+        return list;
+    };
+
+    Fields &f = decodedFields;
+    f.hasType = stringField(TypeKey, &f.type);
+    f.type = internString(f.type);
+    f.hasName = stringField(NameKey, &f.name);
+    f.hasExec = stringField(ExecKey, &f.exec);
+    f.hasUrl = stringField(URLKey, &f.url);
+    f.hasXMaemoService = stringField(XMaemoServiceKey, &f.xMaemoService);
+    stringField(VersionKey, &f.version);
+    stringField(GenericNameKey, &f.genericName);
+    stringField(CommentKey, &f.comment);
+    stringField(IconKey, &f.icon);
+    stringField(TryExecKey, &f.tryExec);
+    stringField(PathKey, &f.path);
+    stringField(StartupWMClassKey, &f.startupWMClass);
+    f.onlyShowIn = listField(OnlyShowInKey);
+    f.notShowIn = listField(NotShowInKey);
+    f.mimeType = listField(MimeTypeKey);
+    f.categories = listField(CategoriesKey);
+    f.noDisplay = boolValue(DesktopEntrySection, NoDisplayKey);
+    f.hidden = boolValue(DesktopEntrySection, HiddenKey);
+    f.terminal = boolValue(DesktopEntrySection, TerminalKey);
+    f.startupNotify = boolValue(DesktopEntrySection, StartupNotifyKey);
+    f.sandboxed = keyFile.hasSection(SailjailSection)
+            && (!keyFile.contains(SailjailSection, SandboxingKey)
+                || keyFile.stringValue(SailjailSection, SandboxingKey) != DisabledValue);
+
+    fieldsDecoded.storeRelease(1);
+    return decodedFields;
+}
 
+QSharedPointer<const QTranslator> MDesktopEntryPrivate::loadTranslator() const
+{
     QString catalog;
     if (keyFile.contains(DesktopEntrySection, TranslationCatalogKey))
         catalog = keyFile.stringValue(DesktopEntrySection, TranslationCatalogKey);
     else if (keyFile.contains(DesktopEntrySection, LegacyTranslationCatalogKey))
         catalog = keyFile.stringValue(DesktopEntrySection, LegacyTranslationCatalogKey);
 
-    if (catalog.isEmpty() || !translator->load(QLocale(), catalog, "-", "/usr/share/translations")) {
-        qCDebug(lcMlite) << "Unable to load catalog" << catalog;
-        delete translator;
-        translator = 0;
-        translatorUnavailable = true;
+    return MTranslations::translator(catalog);
+}
+
+QString MDesktopEntryPrivate::translateValue(const QString &group, const QString &key) const
+{
+    QString value;
+
+    QString logicalIdKey = TranslationIdTemplate.arg(key);
+    if (group == DesktopEntrySection && key == NameKey && keyFile.contains(DesktopEntrySection, LegacyTranslationIdKey))
+        logicalIdKey = LegacyTranslationIdKey;
+
+    if (keyFile.contains(group, logicalIdKey)) {
+        QString trKey = keyFile.stringValue(group, logicalIdKey);
+        QString translation;
+        const QSharedPointer<const QTranslator> translator = loadTranslator();
+        if (translator)
+            translation = translator->translate(0, trKey.toLatin1().data(), 0, -1);
+        else
+            translation = qtTrId(trKey.toLatin1().data());
+
+        if (!translation.isEmpty() && translation != trKey)
+            value = std::move(translation);
     }
 
-    if (translator) {
-        cachedTranslator.reset(translator);
-        translatorCacheTimer.reset(new QTimer);
-        translatorCacheTimer->setSingleShot(true);
-        translatorCacheTimer->setInterval(TranslatorLifetime);
-        QObject::connect(translatorCacheTimer.data(), &QTimer::timeout, [this] {
-            cachedTranslator.reset();
-            translatorCacheTimer.reset();
-        });
+    if (value.isEmpty())
+        value = keyFile.localizedValue(group, key);
+
+    return value;
+}
+
+QString MDesktopEntryPrivate::localizedValue(const QString &group, const QString &key) const
+{
+    QMutexLocker locker(&cacheMutex);
+    updateLocalizedValues();
+
+    const QPair<QString, QString> groupKey(group, key);
+    QHash<QPair<QString, QString>, QString>::const_iterator it = localizedValues.constFind(groupKey);
+    if (it != localizedValues.constEnd())
+        return it.value();
+
+    const QString value = translateValue(group, key);
+    localizedValues.insert(groupKey, value);
+    return value;
+}
+
+void MDesktopEntryPrivate::updateLocalizedValues() const
+{
+    const int generation = MTranslations::localeGeneration();
+    if (generation == localizedGeneration)
+        return;
+
+    localizedGeneration = generation;
+    localizedValues.clear();
+
+    if (!keyFile.hasSection(DesktopEntrySection))
+        return;
+
+    QStringList keys;
+    keys << NameKey << GenericNameKey << CommentKey;
+    for (const QString &key : keyFile.keys(DesktopEntrySection)) {
+        if (key.startsWith(TranslationIdPrefix))
+            keys << key.mid(TranslationIdPrefix.length());
+    }
+
+    for (const QString &key : keys) {
+        const QPair<QString, QString> groupKey(DesktopEntrySection, key);
+        if (!localizedValues.contains(groupKey) && keyFile.contains(DesktopEntrySection, key))
+            localizedValues.insert(groupKey, translateValue(DesktopEntrySection, key));
     }
-    return translator;
 }
 
 /**
@@ -292,7 +919,7 @@ QTranslator *MDesktopEntryPrivate::loadTranslator() const
  **/
 bool MDesktopEntry::readDesktopFile(QIODevice &device, QMap<QString, QString> &desktopEntriesMap)
 {
-    GKeyFileWrapper f;
+    KeyFile f;
 
     if (!f.load(device)) {
         return false;
@@ -308,15 +935,131 @@ bool MDesktopEntry::readDesktopFile(QIODevice &device, QMap<QString, QString> &d
         return false;
     }
 
-    foreach (const QString &section, f.sections()) {
-        foreach (const QString &key, f.keys(section)) {
-            desktopEntriesMap[section + "/" + key] = f.stringValue(section, key);
-        }
+    for (int i = 0; i < f.count(); ++i) {
+        desktopEntriesMap[f.section(i) + "/" + f.key(i)] = f.stringValue(i);
     }
 
     return true;
 }
 
+bool MDesktopEntry::readDesktopFile(QIODevice &device, const Visitor &visitor)
+{
+    const int ChunkSize = 4096;
+    const int ReadTimeout = 30000;
+
+    QByteArray buffer;
+    int used = 0;
+    int lineNumber = 0;
+    bool atEnd = false;
+    bool hasGroup = false;
+    QString group;
+    QString value;
+
+    while (!atEnd) {
+        if (buffer.size() < used + ChunkSize)
+            buffer.resize(used + ChunkSize);
+
+        const qint64 read = device.read(buffer.data() + used, ChunkSize);
+        if (read < 0) {
+            qCWarning(lcMlite) << "Could not read .desktop file:" << device.errorString();
+            return false;
+        }
+        used += int(read);
+
+        // A sequential device may just not have more data yet, it has ended once none arrives.
+        if (read == 0 && device.atEnd() && !device.waitForReadyRead(ReadTimeout))
+            atEnd = true;
+
+        // Handle the complete lines, the last one also at the end of the device.
+        const char *const data = buffer.constData();
+        int lineStart = 0;
+        while (lineStart < used) {
+            const char *newline = static_cast<const char *>(memchr(data + lineStart, '\n', used - lineStart));
+            if (!newline && !atEnd)
+                break;
+
+            const int end = newline ? int(newline - data) : used;
+            KeyFile::Span name;
+            KeyFile::Span span;
+            int baseLength = 0;
+            switch (KeyFile::parseLine(data, lineStart, end, ++lineNumber, &name, &baseLength, &span)) {
+            case KeyFile::BlankLine:
+                break;
+            case KeyFile::GroupLine:
+                group = QString::fromUtf8(data + name.offset, name.length);
+                /**
+                 * From the spec: The basic format of the desktop entry file requires that
+                 * there be a group header named "Desktop Entry".
+                 **/
+                if (!hasGroup && group != DesktopEntrySection)
+                    return false;
+                hasGroup = true;
+                break;
+            case KeyFile::EntryLine:
+                if (!hasGroup) {
+                    qCWarning(lcMlite) << "Could not load .desktop file: Key file does not start with a group";
+                    return false;
+                }
+                if (!KeyFile::unescape(data + span.offset, span.length, &value, 0))
+                    value.clear();
+                visitor(group, QString::fromUtf8(data + name.offset, name.length), value);
+                break;
+            case KeyFile::InvalidLine:
+                return false;
+            }
+
+            lineStart = end + 1;
+        }
+
+        // Keep the incomplete last line for the next chunk.
+        if (lineStart > 0) {
+            used = qMax(used - lineStart, 0);
+            memmove(buffer.data(), buffer.constData() + lineStart, used);
+        }
+    }
+
+    return hasGroup;
+}
+
+QList<MDesktopEntry> MDesktopEntry::loadAll(const QStringList &fileNames)
+{
+    QVector<MDesktopEntryPrivate *> entries(fileNames.count());
+    MDesktopEntryPrivate **const data = entries.data();
+    QAtomicInt next(0);
+
+    const auto load = [&fileNames, data, &next] {
+        for (int i = next.fetchAndAddRelaxed(1); i < fileNames.count(); i = next.fetchAndAddRelaxed(1)) {
+            MDesktopEntryPrivate *d = new MDesktopEntryPrivate(fileNames.at(i));
+            d->fields();
+            QMutexLocker locker(&d->cacheMutex);
+            d->updateLocalizedValues();
+            data[i] = d;
+        }
+    };
+
+    // The calling thread takes part, so the result doesn't depend on the pool having free threads.
+    QThreadPool *pool = QThreadPool::globalInstance();
+    const int workerCount = qMin(pool->maxThreadCount(), fileNames.count() - 1);
+    QSemaphore finished;
+    int started = 0;
+    for (; started < workerCount; ++started) {
+        // The pool only takes ownership of a runnable it starts.
+        QScopedPointer<DesktopEntryLoader> loader(new DesktopEntryLoader(load, &finished));
+        if (!pool->tryStart(loader.data()))
+            break;
+        loader.take();
+    }
+
+    load();
+    finished.acquire(started);
+
+    QList<MDesktopEntry> result;
+    result.reserve(entries.count());
+    for (MDesktopEntryPrivate *entry : entries)
+        result.append(MDesktopEntry(*entry));
+    return result;
+}
+
 bool MDesktopEntryPrivate::boolValue(const QString &section, const QString &key) const
 {
     if (!keyFile.contains(section, key)) {
@@ -331,19 +1074,60 @@ QStringList MDesktopEntryPrivate::stringListValue(const QString &section, const
     return keyFile.stringList(section, key);
 }
 
+MDesktopEntry::MDesktopEntry()
+    : d_ptr(sharedNullPrivate())
+{
+    d_ptr->ref.ref();
+}
+
 MDesktopEntry::MDesktopEntry(const QString &fileName)
     : d_ptr(new MDesktopEntryPrivate(fileName))
 {
+    d_ptr->ref.ref();
 }
 
 MDesktopEntry::MDesktopEntry(MDesktopEntryPrivate &dd)
     : d_ptr(&dd)
 {
+    d_ptr->ref.ref();
+}
+
+MDesktopEntry::MDesktopEntry(const MDesktopEntry &other)
+    : d_ptr(other.d_ptr)
+{
+    if (d_ptr)
+        d_ptr->ref.ref();
+}
+
+MDesktopEntry::MDesktopEntry(MDesktopEntry &&other) noexcept
+    : d_ptr(sharedNullPrivate())
+{
+    d_ptr->ref.ref();
+    swap(other);
 }
 
 MDesktopEntry::~MDesktopEntry()
 {
-    delete d_ptr;
+    if (d_ptr && !d_ptr->ref.deref())
+        delete d_ptr;
+}
+
+MDesktopEntry &MDesktopEntry::operator=(const MDesktopEntry &other)
+{
+    MDesktopEntry copy(other);
+    swap(copy);
+    return *this;
+}
+
+MDesktopEntry &MDesktopEntry::operator=(MDesktopEntry &&other) noexcept
+{
+    swap(other);
+    return *this;
+}
+
+void MDesktopEntry::swap(MDesktopEntry &other) noexcept
+{
+    qSwap(d_ptr, other.d_ptr);
 }
 
 QString MDesktopEntry::fileName() const
@@ -387,29 +1171,7 @@ QString MDesktopEntry::localizedValue(const QString &group, const QString &key)
 {
     Q_D(const MDesktopEntry);
 
-    QString value;
-
-    QString logicalIdKey = TranslationIdTemplate.arg(key);
-    if (group == DesktopEntrySection && key == NameKey && contains(DesktopEntrySection, LegacyTranslationIdKey))
-        logicalIdKey = LegacyTranslationIdKey;
-
-    if (contains(group, logicalIdKey)) {
-        QString trKey = d->keyFile.stringValue(group, logicalIdKey);
-        QString translation;
-        QTranslator *translator = d->loadTranslator();
-        if (translator)
-            translation = translator->translate(0, trKey.toLatin1().data(), 0, -1);
-        else
-            translation = qtTrId(trKey.toLatin1().data());
-
-        if (!translation.isEmpty() && translation != trKey)
-            value = std::move(translation);
-    }
-
-    if (value.isEmpty())
-        value = d->keyFile.localizedValue(group, key);
-
-    return value;
+    return d->localizedValue(group, key);
 }
 
 QStringList MDesktopEntry::stringListValue(const QString &key) const
@@ -429,25 +1191,27 @@ QStringList MDesktopEntry::stringListValue(const QString &group, const QString &
 
 bool MDesktopEntry::isValid() const
 {
+    const MDesktopEntryPrivate::Fields &fields = d_ptr->fields();
+
     // The Type and Name keys always have to be present
-    if (!contains(DesktopEntrySection, TypeKey)) {
+    if (!fields.hasType) {
         return false;
     }
 
-    if (!contains(DesktopEntrySection, NameKey)) {
+    if (!fields.hasName) {
         return false;
     }
 
     // In case of an application either the Exec key needs to be present or D-Bus activation supported
-    if (type() == QStringLiteral("Application") &&
-            !contains(DesktopEntrySection, ExecKey) &&
+    if (fields.type == QStringLiteral("Application") &&
+            !fields.hasExec &&
             // MER#1557: Migrate to freedesktop.org DBusActivatable API
-            !contains(DesktopEntrySection, XMaemoServiceKey)) {
+            !fields.hasXMaemoService) {
         return false;
     }
 
     // In case of a link the URL key needs to be present
-    if (type() == "Link" && !contains(DesktopEntrySection, URLKey)) {
+    if (fields.type == QStringLiteral("Link") && !fields.hasUrl) {
         return false;
     }
 
@@ -469,154 +1233,111 @@ uint MDesktopEntry::hash() const
 QString MDesktopEntry::type() const
 {
     // Type always has to be present (see isValid())
-    return value(DesktopEntrySection, TypeKey);
+    return d_ptr->fields().type;
 }
 
 QString MDesktopEntry::version() const
 {
-    if (!contains(DesktopEntrySection, VersionKey)) {
-        return QString();
-    }
-
-    return value(DesktopEntrySection, VersionKey);
+    return d_ptr->fields().version;
 }
 
 QString MDesktopEntry::name() const
 {
-    Q_D(const MDesktopEntry);
-
-    if (!d->translatedName.isEmpty())
-        return d->translatedName;
-
-    QString name = localizedValue(DesktopEntrySection, NameKey);
-    d->translatedName = name;
-    return name;
+    return localizedValue(DesktopEntrySection, NameKey);
 }
 
 QString MDesktopEntry::nameUnlocalized() const
 {
     // Name always has to be present (see isValid())
-    return value(DesktopEntrySection, NameKey);
+    return d_ptr->fields().name;
 }
 
 QString MDesktopEntry::genericName() const
 {
-    return value(DesktopEntrySection, GenericNameKey);
+    return d_ptr->fields().genericName;
 }
 
 bool MDesktopEntry::noDisplay() const
 {
-    if (!contains(DesktopEntrySection, NoDisplayKey)) {
-        return false;
-    }
-
-    return d_ptr->boolValue(DesktopEntrySection, NoDisplayKey);
+    return d_ptr->fields().noDisplay;
 }
 
 QString MDesktopEntry::comment() const
 {
-    return value(DesktopEntrySection, CommentKey);
+    return d_ptr->fields().comment;
 }
 
 QString MDesktopEntry::icon() const
 {
-    return value(DesktopEntrySection, IconKey);
+    return d_ptr->fields().icon;
 }
 
 bool MDesktopEntry::hidden() const
 {
-    if (!contains(DesktopEntrySection, HiddenKey)) {
-        return false;
-    }
-
-    return d_ptr->boolValue(DesktopEntrySection, HiddenKey);
+    return d_ptr->fields().hidden;
 }
 
 QStringList MDesktopEntry::onlyShowIn() const
 {
-    if (!contains(DesktopEntrySection, OnlyShowInKey)) {
-        return QStringList();
-    }
-
-    return d_ptr->stringListValue(DesktopEntrySection, OnlyShowInKey);
+    return d_ptr->fields().onlyShowIn;
 }
 
 QStringList MDesktopEntry::notShowIn() const
 {
-    if (!contains(DesktopEntrySection, NotShowInKey)) {
-        return QStringList();
-    }
-
-    return d_ptr->stringListValue(DesktopEntrySection, NotShowInKey);
+    return d_ptr->fields().notShowIn;
 }
 
 QString MDesktopEntry::tryExec() const
 {
-    return value(DesktopEntrySection, TryExecKey);
+    return d_ptr->fields().tryExec;
 }
 
 QString MDesktopEntry::exec() const
 {
-    return value(DesktopEntrySection, ExecKey);
+    return d_ptr->fields().exec;
 }
 
 QString MDesktopEntry::xMaemoService() const
 {
-    return value(DesktopEntrySection, XMaemoServiceKey);
+    return d_ptr->fields().xMaemoService;
 }
 
 QString MDesktopEntry::path() const
 {
-    return value(DesktopEntrySection, PathKey);
+    return d_ptr->fields().path;
 }
 
 bool MDesktopEntry::terminal() const
 {
-    if (!contains(DesktopEntrySection, TerminalKey)) {
-        return false;
-    }
-
-    return d_ptr->boolValue(DesktopEntrySection, TerminalKey);
+    return d_ptr->fields().terminal;
 }
 
 QStringList MDesktopEntry::mimeType() const
 {
-    if (!contains(DesktopEntrySection, MimeTypeKey)) {
-        return QStringList();
-    }
-
-    return d_ptr->stringListValue(DesktopEntrySection, MimeTypeKey);
+    return d_ptr->fields().mimeType;
 }
 
 QStringList MDesktopEntry::categories() const
 {
-    if (!contains(DesktopEntrySection, CategoriesKey)) {
-        return QStringList();
-    }
-
-    return d_ptr->stringListValue(DesktopEntrySection, CategoriesKey);
+    return d_ptr->fields().categories;
 }
 
 bool MDesktopEntry::startupNotify() const
 {
-    if (!contains(DesktopEntrySection, StartupNotifyKey)) {
-        return false;
-    }
-
-    return d_ptr->boolValue(DesktopEntrySection, StartupNotifyKey);
+    return d_ptr->fields().startupNotify;
 }
 
 QString MDesktopEntry::startupWMClass() const
 {
-    return value(DesktopEntrySection, StartupWMClassKey);
+    return d_ptr->fields().startupWMClass;
 }
 
 QString MDesktopEntry::url() const
 {
-    return value(DesktopEntrySection, URLKey);
+    return d_ptr->fields().url;
 }
 
 bool MDesktopEntry::isSandboxed() const
 {
-    return d_ptr->keyFile.hasSection(SailjailSection) && value(SailjailSection, SandboxingKey) != DisabledValue;
+    return d_ptr->fields().sandboxed;
 }
@@ -21,6 +21,9 @@
 #include <mlite-global.h>
 #include <QMap>
 #include <QIODevice>
+#include <QList>
+
+#include <functional>
 
 class MDesktopEntryPrivate;
 
@@ -41,6 +44,18 @@ class MDesktopEntryPrivate;
 class MLITESHARED_EXPORT MDesktopEntry
 {
 public:
+    /*!
+     * The function readDesktopFile() calls for each key of a desktop entry
+     * file, with the group, the key including its locale and the unescaped
+     * value.
+     */
+    typedef std::function<void(const QString &group, const QString &key, const QString &value)> Visitor;
+
+    /*!
+     * Constructs an invalid entry without a file.
+     */
+    MDesktopEntry();
+
     /*!
      * Reads input desktop file and constructs new MDesktopEntry object
      * of it.
@@ -49,11 +64,30 @@ public:
      */
     MDesktopEntry(const QString &fileName);
 
+    /*!
+     * Constructs a copy of \a other. The parsed desktop entry is implicitly
+     * shared, copying only takes a reference.
+     */
+    MDesktopEntry(const MDesktopEntry &other);
+
+    /*!
+     * Move constructor, \a other is left an invalid entry without a file.
+     */
+    MDesktopEntry(MDesktopEntry &&other) noexcept;
+
     /*!
      * Destroys the MDesktopEntry.
      */
     virtual ~MDesktopEntry();
 
+    MDesktopEntry &operator=(const MDesktopEntry &other);
+    MDesktopEntry &operator=(MDesktopEntry &&other) noexcept;
+
+    /*!
+     * Swaps this desktop entry with \a other.
+     */
+    void swap(MDesktopEntry &other) noexcept;
+
     /*!
      * Returns the name of the file where the information for this
      * desktop entry was read from.
@@ -250,6 +284,33 @@ public:
      */
     static bool readDesktopFile(QIODevice &device, QMap<QString, QString> &desktopEntriesMap);
 
+    /*!
+     * Parses a desktop entry file while reading it from \a device, calling
+     * \a visitor for each key in file order. Repeated keys are visited
+     * every time they occur, the last value is the effective one.
+     *
+     * Unlike the QMap variant this neither keeps the whole file in memory
+     * nor builds "group/key" strings. When parsing fails part of the file
+     * may already have been visited. Sequential devices are read until no
+     * more data arrives, and a read error fails the parse.
+     *
+     * \param device the QIODevice to read the desktop file from
+     * \param visitor the function to call for each key
+     * \return true if desktop file can be parsed
+     */
+    static bool readDesktopFile(QIODevice &device, const Visitor &visitor);
+
+    /*!
+     * Reads the desktop entry files in \a fileNames in parallel on the global
+     * QThreadPool and the calling thread. The localized names are resolved
+     * while the files are read, so name() doesn't need to load translation
+     * catalogs on the calling thread.
+     *
+     * \param fileNames the names of the files to read the desktop entries from
+     * \return the desktop entries in the order of \a fileNames, including invalid ones
+     */
+    static QList<MDesktopEntry> loadAll(const QStringList &fileNames);
+
     /*!
      * Returns whether the application is sandboxed.
      */
@@ -269,13 +330,13 @@ public:
 
 protected:
     /*! \internal */
-    //! Pointer to the private class
-    MDesktopEntryPrivate *const d_ptr;
+    //! Pointer to the shared private class
+    MDesktopEntryPrivate *d_ptr;
     MDesktopEntry(MDesktopEntryPrivate &dd);
     /*! \internal_end */
 
 private:
-    Q_DISABLE_COPY(MDesktopEntry)
+    friend class MDesktopEntryCache;
     Q_DECLARE_PRIVATE(MDesktopEntry)
 };
 
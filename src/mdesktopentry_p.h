@@ -18,16 +18,29 @@
 #ifndef MDESKTOPENTRY_P_H
 #define MDESKTOPENTRY_P_H
 
-#include <glib.h>
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+#include <QSharedData>
+#include <QSharedPointer>
+#include <QVector>
 
 class MDesktopEntry;
+class QIODevice;
 class QTranslator;
 
-class GKeyFileWrapper
+/*!
+ * KeyFile tokenizes a desktop entry file once into a flat table of spans over
+ * the file contents. Lookups compare precomputed hashes of the section and key
+ * names, and values are only unescaped and converted when they are read,
+ * following the escape and locale rules of GKeyFile.
+ */
+class KeyFile
 {
 public:
-    GKeyFileWrapper();
-    ~GKeyFileWrapper();
+    KeyFile();
 
     bool load(QIODevice &device);
 
@@ -41,15 +54,77 @@ public:
     bool contains(const QString &section, const QString &key) const;
     bool hasSection(const QString &section) const;
 
+    //! Access to the values in file order, a localized key includes its locale.
+    int count() const;
+    QString section(int index) const;
+    QString key(int index) const;
+    QString stringValue(int index) const;
+
+    //! Access to the values as they are written in the file, before unescaping.
+    QByteArray rawSection(int index) const;
+    QByteArray rawKey(int index) const;
+    QByteArray rawValue(int index) const;
+    void setRawValue(const char *section, const char *key, const char *value);
+
+    struct Span
+    {
+        int offset;
+        int length;
+    };
+
+    enum LineType {
+        BlankLine,
+        GroupLine,
+        EntryLine,
+        InvalidLine
+    };
+
+    //! Classifies the line between start and end, returning the group name or the key and value spans.
+    static LineType parseLine(const char *data, int start, int end, int lineNumber,
+                              Span *name, int *baseLength, Span *value);
+    //! Unescapes a value like g_key_file_parse_value_as_string(), splitting it if list is given.
+    static bool unescape(const char *data, int length, QString *string, QStringList *list);
+
 private:
-    GKeyFile *m_key_file;
+    struct Section
+    {
+        Span name;
+        uint hash;
+    };
+
+    struct Entry
+    {
+        //! Hash of the section and the key without the locale.
+        uint hash;
+        int section;
+        //! The full key, the locale follows the first baseLength bytes in brackets.
+        Span key;
+        int baseLength;
+        Span value;
+    };
+
+    bool parse();
+    Span append(const char *string);
+    int addSection(const Span &name);
+    void addEntry(int section, const Span &key, int baseLength, const Span &value);
+    int findSection(const QString &section) const;
+    int find(const QString &section, const QString &key) const;
+    bool unescape(const Span &value, QString *string, QStringList *list) const;
+
+    QByteArray m_data;
+    QVector<Section> m_sections;
+    QVector<Entry> m_entries;
+    //! Indices of m_entries by Entry::hash, so lookups don't scan the whole file.
+    QMultiHash<uint, int> m_index;
 };
 
 
 /*!
- * MDesktopEntryPrivate is the private class for MDesktopEntry.
+ * MDesktopEntryPrivate is the private class for MDesktopEntry, shared by the
+ * copies of an entry. The parsed file doesn't change after loading, the lazily
+ * filled caches are guarded by cacheMutex.
  */
-class MDesktopEntryPrivate
+class MDesktopEntryPrivate : public QSharedData
 {
     Q_DECLARE_PUBLIC(MDesktopEntry)
 
@@ -61,6 +136,15 @@ public:
      */
     MDesktopEntryPrivate(const QString &fileName);
 
+    /*!
+     * Constructs a new MDesktopEntryPrivate class without reading the file,
+     * the caller populates the keyFile.
+     *
+     * \param fileName the name of the file the desktop entry was read from
+     * \param valid whether the desktop entry was valid when it was parsed
+     */
+    MDesktopEntryPrivate(const QString &fileName, bool valid);
+
     /*!
      * Destroys the MDesktopEntryPrivate.
      */
@@ -69,8 +153,8 @@ public:
     //! The name of the file where the information for this desktop entry was read from.
     QString sourceFileName;
 
-    //! Wrapper around GKeyFile that stores the parsed desktop entry.
-    GKeyFileWrapper keyFile;
+    //! The parsed desktop entry.
+    KeyFile keyFile;
 
     /*!
      * Returns the boolean value of a key.
@@ -94,23 +178,84 @@ public:
     //! Flag to indicate whether the desktop entry is valid during parsing
     bool valid;
 
-    //! Cached translated name
-    mutable QString translatedName;
+    //! The standard keys of the "Desktop Entry" section, decoded once.
+    struct Fields
+    {
+        Fields()
+            : hasType(false), hasName(false), hasExec(false), hasUrl(false), hasXMaemoService(false)
+            , noDisplay(false), hidden(false), terminal(false), startupNotify(false), sandboxed(false)
+        {
+        }
+
+        QString type;
+        QString version;
+        QString name;
+        QString genericName;
+        QString comment;
+        QString icon;
+        QString tryExec;
+        QString exec;
+        QString path;
+        QString startupWMClass;
+        QString url;
+        QString xMaemoService;
+        //! The list items are interned, so equal categories and MIME types share their data.
+        QStringList onlyShowIn;
+        QStringList notShowIn;
+        QStringList mimeType;
+        QStringList categories;
+        bool hasType : 1;
+        bool hasName : 1;
+        bool hasExec : 1;
+        bool hasUrl : 1;
+        bool hasXMaemoService : 1;
+        bool noDisplay : 1;
+        bool hidden : 1;
+        bool terminal : 1;
+        bool startupNotify : 1;
+        bool sandboxed : 1;
+    };
 
     /*!
-     * Loads QTranslator from X-Amber/MeeGo-Translation-Catalog
+     * Returns the standard fields, decoding them from keyFile on first use.
+     * MDesktopEntry::loadAll() decodes them while loading.
+     */
+    const Fields &fields() const;
+
+    mutable Fields decodedFields;
+    mutable QAtomicInt fieldsDecoded;
+
+    /*!
+     * Returns the shared translator for X-Amber/MeeGo-Translation-Catalog
      * \return A translator for specified catalog, or null
      */
-    QTranslator *loadTranslator() const;
+    QSharedPointer<const QTranslator> loadTranslator() const;
 
-    //! Translator cache, limits how long it can live
-    mutable QScopedPointer<QTimer> translatorCacheTimer;
+    /*!
+     * Returns the localized value of a key, translated with the catalog of the
+     * desktop entry if it has a translation id for the key.
+     */
+    QString translateValue(const QString &group, const QString &key) const;
+
+    /*!
+     * Returns the localized value of a key from localizedValues, translating
+     * it on first use in the current locale.
+     */
+    QString localizedValue(const QString &group, const QString &key) const;
+
+    /*!
+     * Clears localizedValues if the locale changed since they were translated,
+     * and translates the localizable keys of the "Desktop Entry" section.
+     * Called with cacheMutex locked.
+     */
+    void updateLocalizedValues() const;
 
-    //! Cached translator
-    mutable QScopedPointer<QTranslator> cachedTranslator;
+    //! Localized values by group and key, valid for localizedGeneration.
+    mutable QHash<QPair<QString, QString>, QString> localizedValues;
+    mutable int localizedGeneration;
 
-    //! Translator is unavailable, don't try to load again
-    mutable bool translatorUnavailable;
+    //! Guards decoding the fields and localizedValues.
+    mutable QMutex cacheMutex;
 
 protected:
     /*
@@ -0,0 +1,306 @@
+/***************************************************************************
+** Copyright (C) 2026 Jolla Ltd.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QStringList>
+
+#include <limits>
+
+#include "mdesktopentry.h"
+#include "mdesktopentry_p.h"
+#include "mdesktopentrycache.h"
+#include "mdesktopentrycache_p.h"
+#include "logging.h"
+
+namespace {
+const quint32 IndexMagic = 0x4945444d; // "MDEI"
+const quint32 IndexVersion = 1;
+const quint32 ValidFlag = 0x1;
+const QString DesktopFilePattern = QStringLiteral("*.desktop");
+}
+
+MDesktopEntryCachePrivate::MDesktopEntryCachePrivate(const QString &indexPath)
+    : indexPath(indexPath)
+    , indexFile(indexPath)
+    , data(0)
+    , indexValues(0)
+    , dataSize(0)
+    , dirty(false)
+{
+}
+
+bool MDesktopEntryCachePrivate::map()
+{
+    if (!indexFile.exists() || !indexFile.open(QIODevice::ReadOnly))
+        return false;
+
+    dataSize = indexFile.size();
+    if (dataSize > qint64(sizeof(IndexHeader)) && dataSize <= qint64(std::numeric_limits<quint32>::max()))
+        data = indexFile.map(0, dataSize);
+
+    const IndexHeader *header = reinterpret_cast<const IndexHeader *>(data);
+    bool valid = data
+            && header->magic == IndexMagic
+            && header->version == IndexVersion
+            && sizeof(IndexHeader)
+                + qint64(header->fileCount) * sizeof(IndexFile)
+                + qint64(header->valueCount) * sizeof(IndexValue) < quint64(dataSize)
+            // Every string is terminated within the mapping if the last byte is nul.
+            && data[dataSize - 1] == '\0';
+
+    const IndexFile *files = 0;
+    if (valid) {
+        files = reinterpret_cast<const IndexFile *>(data + sizeof(IndexHeader));
+        indexValues = reinterpret_cast<const IndexValue *>(files + header->fileCount);
+
+        for (quint32 i = 0; valid && i < header->fileCount; ++i) {
+            valid = files[i].path < dataSize
+                    && quint64(files[i].firstValue) + files[i].valueCount <= header->valueCount;
+        }
+    }
+
+    if (!valid) {
+        qCWarning(lcMlite) << "Ignoring invalid desktop entry index" << indexPath;
+        indexFile.close();
+        data = 0;
+        indexValues = 0;
+        dataSize = 0;
+        return false;
+    }
+
+    for (quint32 i = 0; i < header->fileCount; ++i) {
+        Record record;
+        record.modified = files[i].modified;
+        record.size = files[i].size;
+        record.firstValue = files[i].firstValue;
+        record.valueCount = files[i].valueCount;
+        record.valid = files[i].flags & ValidFlag;
+        record.mapped = true;
+        records.insert(QString::fromUtf8(string(files[i].path)), record);
+    }
+
+    return true;
+}
+
+const char *MDesktopEntryCachePrivate::string(quint32 offset) const
+{
+    return offset < dataSize ? reinterpret_cast<const char *>(data) + offset : "";
+}
+
+MDesktopEntryCachePrivate::Record MDesktopEntryCachePrivate::parse(
+        const QString &fileName, qint64 modified, qint64 size)
+{
+    const MDesktopEntryPrivate entry(fileName);
+
+    Record record;
+    record.modified = modified;
+    record.size = size;
+    record.valid = entry.valid;
+
+    // Store the raw values, they're unescaped on access when served from the cache.
+    const KeyFile &keyFile = entry.keyFile;
+    record.values.reserve(keyFile.count());
+    for (int i = 0; i < keyFile.count(); ++i)
+        record.values.append({ keyFile.rawSection(i), keyFile.rawKey(i), keyFile.rawValue(i) });
+
+    return record;
+}
+
+MDesktopEntryCache::MDesktopEntryCache(const QString &indexPath)
+    : d_ptr(new MDesktopEntryCachePrivate(indexPath))
+{
+    Q_D(MDesktopEntryCache);
+    d->map();
+}
+
+MDesktopEntryCache::~MDesktopEntryCache()
+{
+    delete d_ptr;
+}
+
+QString MDesktopEntryCache::indexPath() const
+{
+    Q_D(const MDesktopEntryCache);
+    return d->indexPath;
+}
+
+void MDesktopEntryCache::scan(const QStringList &directories)
+{
+    Q_D(MDesktopEntryCache);
+
+    QMap<QString, MDesktopEntryCachePrivate::Record> records;
+    for (const QString &directory : directories) {
+        const QFileInfoList files = QDir(directory).entryInfoList(
+                    QStringList(DesktopFilePattern), QDir::Files | QDir::Readable);
+        for (const QFileInfo &file : files) {
+            const QString fileName = file.absoluteFilePath();
+            if (records.contains(fileName))
+                continue;
+
+            const qint64 modified = file.lastModified().toMSecsSinceEpoch();
+            const qint64 size = file.size();
+
+            QMap<QString, MDesktopEntryCachePrivate::Record>::const_iterator it
+                    = d->records.constFind(fileName);
+            if (it != d->records.constEnd() && it->modified == modified && it->size == size) {
+                records.insert(fileName, *it);
+            } else {
+                records.insert(fileName, MDesktopEntryCachePrivate::parse(fileName, modified, size));
+                d->dirty = true;
+            }
+        }
+    }
+
+    // Removed files.
+    if (records.count() != d->records.count())
+        d->dirty = true;
+
+    d->records = records;
+}
+
+QStringList MDesktopEntryCache::fileNames() const
+{
+    Q_D(const MDesktopEntryCache);
+    return d->records.keys();
+}
+
+bool MDesktopEntryCache::contains(const QString &fileName) const
+{
+    Q_D(const MDesktopEntryCache);
+    return d->records.contains(fileName);
+}
+
+MDesktopEntry MDesktopEntryCache::entry(const QString &fileName) const
+{
+    Q_D(const MDesktopEntryCache);
+
+    QMap<QString, MDesktopEntryCachePrivate::Record>::const_iterator it = d->records.constFind(fileName);
+    if (it == d->records.constEnd())
+        return MDesktopEntry(fileName);
+
+    if (!it->entry.fileName().isEmpty())
+        return it->entry;
+
+    MDesktopEntryPrivate *entry = new MDesktopEntryPrivate(fileName, it->valid);
+    if (it->mapped) {
+        for (quint32 i = it->firstValue; i < it->firstValue + it->valueCount; ++i) {
+            const IndexValue &value = d->indexValues[i];
+            entry->keyFile.setRawValue(
+                        d->string(value.section), d->string(value.key), d->string(value.value));
+        }
+    } else {
+        for (const MDesktopEntryCachePrivate::Value &value : it->values) {
+            entry->keyFile.setRawValue(
+                        value.section.constData(), value.key.constData(), value.value.constData());
+        }
+    }
+
+    it->entry = MDesktopEntry(*entry);
+    return it->entry;
+}
+
+bool MDesktopEntryCache::save()
+{
+    Q_D(MDesktopEntryCache);
+
+    if (!d->dirty)
+        return true;
+
+    quint32 valueCount = 0;
+    for (const MDesktopEntryCachePrivate::Record &record : d->records)
+        valueCount += record.mapped ? record.valueCount : record.values.count();
+
+    const quint32 poolStart = sizeof(IndexHeader)
+            + d->records.count() * sizeof(IndexFile)
+            + valueCount * sizeof(IndexValue);
+
+    // Sections, keys and many values are shared between files so only store them once.
+    QByteArray pool(1, '\0');
+    QHash<QByteArray, quint32> offsets;
+    const auto intern = [&](const QByteArray &string) {
+        QHash<QByteArray, quint32>::const_iterator it = offsets.constFind(string);
+        if (it != offsets.constEnd())
+            return it.value();
+
+        const quint32 offset = poolStart + pool.size();
+        pool.append(string.constData(), string.size());
+        pool.append('\0');
+        offsets.insert(string, offset);
+        return offset;
+    };
+    const auto internMapped = [&](quint32 offset) {
+        return intern(QByteArray(d->string(offset)));
+    };
+
+    QVector<IndexFile> files;
+    QVector<IndexValue> values;
+    files.reserve(d->records.count());
+    values.reserve(valueCount);
+
+    for (QMap<QString, MDesktopEntryCachePrivate::Record>::const_iterator it = d->records.constBegin();
+            it != d->records.constEnd();
+            ++it) {
+        IndexFile file;
+        file.path = intern(it.key().toUtf8());
+        file.firstValue = values.count();
+        file.flags = it->valid ? ValidFlag : 0;
+        file.modified = it->modified;
+        file.size = it->size;
+
+        if (it->mapped) {
+            for (quint32 i = it->firstValue; i < it->firstValue + it->valueCount; ++i) {
+                const IndexValue &mapped = d->indexValues[i];
+                values.append({
+                    internMapped(mapped.section), internMapped(mapped.key), internMapped(mapped.value)
+                });
+            }
+        } else {
+            for (const MDesktopEntryCachePrivate::Value &value : it->values)
+                values.append({ intern(value.section), intern(value.key), intern(value.value) });
+        }
+
+        file.valueCount = values.count() - file.firstValue;
+        files.append(file);
+    }
+
+    IndexHeader header;
+    header.magic = IndexMagic;
+    header.version = IndexVersion;
+    header.fileCount = files.count();
+    header.valueCount = values.count();
+
+    QDir().mkpath(QFileInfo(d->indexPath).absolutePath());
+
+    QSaveFile file(d->indexPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(lcMlite) << "Could not write desktop entry index" << d->indexPath << file.errorString();
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(files.constData()), files.count() * sizeof(IndexFile));
+    file.write(reinterpret_cast<const char *>(values.constData()), values.count() * sizeof(IndexValue));
+    file.write(pool);
+
+    if (!file.commit()) {
+        qCWarning(lcMlite) << "Could not write desktop entry index" << d->indexPath << file.errorString();
+        return false;
+    }
+
+    // Mapped records continue to refer to the previous index, which stays mapped.
+    d->dirty = false;
+    return true;
+}
@@ -0,0 +1,104 @@
+/***************************************************************************
+** Copyright (C) 2026 Jolla Ltd.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef MDESKTOPENTRYCACHE_H_
+#define MDESKTOPENTRYCACHE_H_
+
+#include <mlite-global.h>
+#include <QStringList>
+
+class MDesktopEntry;
+class MDesktopEntryCachePrivate;
+
+/*!
+ * MDesktopEntryCache keeps the parsed contents of the desktop entry files
+ * in a set of directories in a binary index file, so they can be served
+ * without reading and parsing every file again.
+ *
+ * The index is memory mapped when the cache is constructed. scan() compares
+ * the modification time and size of each desktop file with the index and
+ * only parses files which have been added or changed since, and save()
+ * atomically replaces the index if anything changed.
+ *
+ * \code
+ * MDesktopEntryCache cache(indexPath);
+ * cache.scan(QStringList() << "/usr/share/applications");
+ * for (const QString &fileName : cache.fileNames()) {
+ *     const MDesktopEntry entry = cache.entry(fileName);
+ *     ...
+ * }
+ * cache.save();
+ * \endcode
+ */
+class MLITESHARED_EXPORT MDesktopEntryCache
+{
+public:
+    /*!
+     * Constructs a cache backed by the index file at \a indexPath. The index
+     * is loaded if it exists and is valid.
+     *
+     * \param indexPath the path of the index file to read and write
+     */
+    explicit MDesktopEntryCache(const QString &indexPath);
+
+    /*!
+     * Destroys the MDesktopEntryCache. Unsaved changes are discarded.
+     */
+    ~MDesktopEntryCache();
+
+    /*!
+     * Returns the path of the index file.
+     */
+    QString indexPath() const;
+
+    /*!
+     * Updates the cache to contain the desktop files in \a directories.
+     * Files which are unchanged since they were indexed are not read,
+     * files which were removed are dropped from the cache.
+     *
+     * \param directories the directories to scan for .desktop files
+     */
+    void scan(const QStringList &directories);
+
+    /*!
+     * Returns the absolute paths of all desktop files in the cache.
+     */
+    QStringList fileNames() const;
+
+    /*!
+     * Returns whether the cache has an entry for \a fileName.
+     */
+    bool contains(const QString &fileName) const;
+
+    /*!
+     * Returns a desktop entry for \a fileName. If the file is not in the
+     * cache it is read from the file system. The entry of a cached file is
+     * built on the first call and shared by later ones.
+     *
+     * \param fileName the absolute path of the desktop file
+     */
+    MDesktopEntry entry(const QString &fileName) const;
+
+    /*!
+     * Writes the index file if the cache changed since it was loaded or last
+     * saved.
+     *
+     * \return true if the index is up to date
+     */
+    bool save();
+
+private:
+    Q_DISABLE_COPY(MDesktopEntryCache)
+    MDesktopEntryCachePrivate *const d_ptr;
+    Q_DECLARE_PRIVATE(MDesktopEntryCache)
+};
+
+#endif /* MDESKTOPENTRYCACHE_H_ */
@@ -0,0 +1,99 @@
+/***************************************************************************
+** Copyright (C) 2026 Jolla Ltd.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef MDESKTOPENTRYCACHE_P_H
+#define MDESKTOPENTRYCACHE_P_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QMap>
+#include <QString>
+#include <QVector>
+
+#include "mdesktopentry.h"
+
+/*
+ * Layout of the index file, all integers are in native byte order and all offsets are from the
+ * start of the file:
+ *
+ * IndexHeader
+ * IndexFile[fileCount], sorted by path
+ * IndexValue[valueCount], the values of each file are contiguous
+ * string pool of nul terminated UTF-8 strings, ending with a nul byte
+ */
+struct IndexHeader
+{
+    quint32 magic;
+    quint32 version;
+    quint32 fileCount;
+    quint32 valueCount;
+};
+
+struct IndexFile
+{
+    quint32 path;
+    quint32 firstValue;
+    quint32 valueCount;
+    quint32 flags;
+    qint64 modified;
+    qint64 size;
+};
+
+struct IndexValue
+{
+    quint32 section;
+    quint32 key;
+    quint32 value;
+};
+
+class MDesktopEntryCachePrivate
+{
+public:
+    //! A raw, still escaped, value of a desktop file parsed since the index was loaded.
+    struct Value
+    {
+        QByteArray section;
+        QByteArray key;
+        QByteArray value;
+    };
+
+    struct Record
+    {
+        Record() : modified(0), size(0), firstValue(0), valueCount(0), valid(false), mapped(false) {}
+
+        qint64 modified;
+        qint64 size;
+        //! The values in the mapped index if mapped, otherwise values holds them.
+        quint32 firstValue;
+        quint32 valueCount;
+        QVector<Value> values;
+        //! The entry built from the values by the first entry() call, without a file until then.
+        mutable MDesktopEntry entry;
+        bool valid;
+        bool mapped;
+    };
+
+    explicit MDesktopEntryCachePrivate(const QString &indexPath);
+
+    bool map();
+    const char *string(quint32 offset) const;
+    static Record parse(const QString &fileName, qint64 modified, qint64 size);
+
+    QString indexPath;
+    QMap<QString, Record> records;
+    QFile indexFile;
+    const uchar *data;
+    const IndexValue *indexValues;
+    qint64 dataSize;
+    bool dirty;
+};
+
+#endif /* MDESKTOPENTRYCACHE_P_H */
@@ -0,0 +1,243 @@
+/***************************************************************************
+** Copyright (C) 2026 Jolla Ltd.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#include <QFileInfo>
+#include <QPair>
+
+#include <algorithm>
+
+#include "mdesktopentry.h"
+#include "mdesktopentrysearchindex.h"
+#include "mdesktopentrysearchindex_p.h"
+
+namespace {
+const QString DesktopEntrySection = QStringLiteral("Desktop Entry");
+const QString GenericNameKey = QStringLiteral("GenericName");
+const QString CommentKey = QStringLiteral("Comment");
+const QString KeywordsKey = QStringLiteral("Keywords");
+
+enum Weight {
+    NameWeight = 100,
+    GenericNameWeight = 50,
+    KeywordWeight = 40,
+    CategoryWeight = 30,
+    CommentWeight = 20,
+    ExecWeight = 15,
+    MimeTypeWeight = 10,
+    // Added when the name starts with the whole query.
+    NamePrefixBonus = 100
+};
+
+void addWords(QHash<QString, int> *weights, const QStringList &words, int weight)
+{
+    for (const QString &word : words) {
+        int &current = (*weights)[word];
+        current = qMax(current, weight);
+    }
+}
+}
+
+QStringList MDesktopEntrySearchIndexPrivate::words(const QString &text)
+{
+    QStringList result;
+
+    const QString folded = text.toCaseFolded();
+    int start = -1;
+    for (int i = 0; i <= folded.size(); ++i) {
+        if (i < folded.size() && folded.at(i).isLetterOrNumber()) {
+            if (start < 0)
+                start = i;
+        } else if (start >= 0) {
+            result.append(folded.mid(start, i - start));
+            start = -1;
+        }
+    }
+
+    return result;
+}
+
+void MDesktopEntrySearchIndexPrivate::add(int document, const QHash<QString, int> &weights)
+{
+    Document &target = documents[document];
+    target.words.reserve(weights.count());
+    for (QHash<QString, int>::const_iterator it = weights.constBegin(); it != weights.constEnd(); ++it) {
+        const Posting posting = { document, it.value() };
+        postings[it.key()].append(posting);
+        target.words.append(it.key());
+    }
+}
+
+void MDesktopEntrySearchIndexPrivate::removeDocument(int document)
+{
+    Document &target = documents[document];
+    for (const QString &word : target.words) {
+        QMap<QString, QVector<Posting> >::iterator it = postings.find(word);
+        if (it == postings.end())
+            continue;
+
+        QVector<Posting> &list = it.value();
+        for (int i = 0; i < list.count(); ++i) {
+            if (list.at(i).document == document) {
+                list.remove(i);
+                break;
+            }
+        }
+        if (list.isEmpty())
+            postings.erase(it);
+    }
+
+    target = Document();
+    freeDocuments.append(document);
+}
+
+MDesktopEntrySearchIndex::MDesktopEntrySearchIndex()
+    : d_ptr(new MDesktopEntrySearchIndexPrivate)
+{
+}
+
+MDesktopEntrySearchIndex::~MDesktopEntrySearchIndex()
+{
+    delete d_ptr;
+}
+
+void MDesktopEntrySearchIndex::insert(const MDesktopEntry &entry)
+{
+    Q_D(MDesktopEntrySearchIndex);
+
+    if (entry.fileName().isEmpty())
+        return;
+
+    remove(entry.fileName());
+
+    const QString name = entry.name();
+
+    QHash<QString, int> weights;
+    addWords(&weights, d->words(name), NameWeight);
+    addWords(&weights, d->words(entry.localizedValue(DesktopEntrySection, GenericNameKey)), GenericNameWeight);
+    if (entry.contains(DesktopEntrySection, KeywordsKey))
+        addWords(&weights, d->words(entry.localizedValue(DesktopEntrySection, KeywordsKey)), KeywordWeight);
+    addWords(&weights, d->words(entry.categories().join(QLatin1Char(' '))), CategoryWeight);
+    addWords(&weights, d->words(entry.localizedValue(DesktopEntrySection, CommentKey)), CommentWeight);
+    addWords(&weights, d->words(QFileInfo(entry.exec().section(QLatin1Char(' '), 0, 0)).fileName()), ExecWeight);
+    addWords(&weights, d->words(entry.mimeType().join(QLatin1Char(' '))), MimeTypeWeight);
+
+    int document;
+    if (!d->freeDocuments.isEmpty()) {
+        document = d->freeDocuments.takeLast();
+    } else {
+        document = d->documents.count();
+        d->documents.append(MDesktopEntrySearchIndexPrivate::Document());
+    }
+
+    d->documents[document].entry = entry;
+    d->documents[document].sortName = name.toCaseFolded();
+    d->documentsByFileName.insert(entry.fileName(), document);
+    d->add(document, weights);
+}
+
+void MDesktopEntrySearchIndex::remove(const QString &fileName)
+{
+    Q_D(MDesktopEntrySearchIndex);
+
+    QHash<QString, int>::iterator it = d->documentsByFileName.find(fileName);
+    if (it == d->documentsByFileName.end())
+        return;
+
+    d->removeDocument(it.value());
+    d->documentsByFileName.erase(it);
+}
+
+void MDesktopEntrySearchIndex::clear()
+{
+    Q_D(MDesktopEntrySearchIndex);
+
+    d->postings.clear();
+    d->documents.clear();
+    d->freeDocuments.clear();
+    d->documentsByFileName.clear();
+}
+
+int MDesktopEntrySearchIndex::count() const
+{
+    Q_D(const MDesktopEntrySearchIndex);
+    return d->documentsByFileName.count();
+}
+
+QList<MDesktopEntry> MDesktopEntrySearchIndex::search(const QString &query, int limit) const
+{
+    Q_D(const MDesktopEntrySearchIndex);
+
+    QList<MDesktopEntry> result;
+
+    const QStringList queryWords = d->words(query);
+    if (queryWords.isEmpty() || limit == 0)
+        return result;
+
+    // Every word has to match, a document scores its best posting for each word.
+    QHash<int, int> scores;
+    for (int i = 0; i < queryWords.count(); ++i) {
+        const QString &word = queryWords.at(i);
+
+        QHash<int, int> wordScores;
+        for (QMap<QString, QVector<MDesktopEntrySearchIndexPrivate::Posting> >::const_iterator it
+                    = d->postings.lowerBound(word);
+                it != d->postings.constEnd() && it.key().startsWith(word);
+                ++it) {
+            const bool whole = it.key().size() == word.size();
+            for (const MDesktopEntrySearchIndexPrivate::Posting &posting : it.value()) {
+                int &score = wordScores[posting.document];
+                score = qMax(score, whole ? 2 * posting.weight : posting.weight);
+            }
+        }
+
+        if (i == 0) {
+            scores = wordScores;
+        } else {
+            for (QHash<int, int>::iterator it = scores.begin(); it != scores.end();) {
+                QHash<int, int>::const_iterator match = wordScores.constFind(it.key());
+                if (match == wordScores.constEnd()) {
+                    it = scores.erase(it);
+                } else {
+                    it.value() += match.value();
+                    ++it;
+                }
+            }
+        }
+
+        if (scores.isEmpty())
+            return result;
+    }
+
+    const QString folded = query.trimmed().toCaseFolded();
+
+    QVector<QPair<int, int> > ranked;
+    ranked.reserve(scores.count());
+    for (QHash<int, int>::const_iterator it = scores.constBegin(); it != scores.constEnd(); ++it) {
+        int score = it.value();
+        if (d->documents.at(it.key()).sortName.startsWith(folded))
+            score += NamePrefixBonus;
+        ranked.append(qMakePair(score, it.key()));
+    }
+
+    const QVector<MDesktopEntrySearchIndexPrivate::Document> &documents = d->documents;
+    std::sort(ranked.begin(), ranked.end(), [&documents](const QPair<int, int> &a, const QPair<int, int> &b) {
+        if (a.first != b.first)
+            return a.first > b.first;
+        return documents.at(a.second).sortName < documents.at(b.second).sortName;
+    });
+
+    const int count = limit < 0 ? ranked.count() : qMin(limit, ranked.count());
+    result.reserve(count);
+    for (int i = 0; i < count; ++i)
+        result.append(documents.at(ranked.at(i).second).entry);
+
+    return result;
+}
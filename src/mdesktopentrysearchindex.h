@@ -0,0 +1,86 @@
+/***************************************************************************
+** Copyright (C) 2026 Jolla Ltd.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef MDESKTOPENTRYSEARCHINDEX_H_
+#define MDESKTOPENTRYSEARCHINDEX_H_
+
+#include <mlite-global.h>
+#include <QList>
+#include <QString>
+
+class MDesktopEntry;
+class MDesktopEntrySearchIndexPrivate;
+
+/*!
+ * MDesktopEntrySearchIndex finds desktop entries by words of their
+ * localized name, generic name, comment and keywords, their categories,
+ * MIME types and executable.
+ *
+ * Words are case folded and kept in an ordered table, so each word of a
+ * query is matched as a prefix with a binary search instead of a scan over
+ * all entries. Entries can be inserted and removed at any time, for
+ * example from the signals of MDesktopEntryWatcher.
+ *
+ * The localized values are indexed in the locale current at insertion,
+ * insert the entries again after a locale change.
+ */
+class MLITESHARED_EXPORT MDesktopEntrySearchIndex
+{
+public:
+    /*!
+     * Constructs an empty index.
+     */
+    MDesktopEntrySearchIndex();
+
+    /*!
+     * Destroys the MDesktopEntrySearchIndex.
+     */
+    ~MDesktopEntrySearchIndex();
+
+    /*!
+     * Adds \a entry to the index, replacing an entry with the same file name.
+     * Entries without a file name are ignored.
+     */
+    void insert(const MDesktopEntry &entry);
+
+    /*!
+     * Removes the entry read from \a fileName from the index.
+     */
+    void remove(const QString &fileName);
+
+    /*!
+     * Removes all entries from the index.
+     */
+    void clear();
+
+    /*!
+     * Returns the number of entries in the index.
+     */
+    int count() const;
+
+    /*!
+     * Returns the entries matching every word of \a query as a prefix of one
+     * of their words, best match first. Matches in the name rank above
+     * matches in the generic name, keywords, categories, comment, executable
+     * and MIME types, and whole word matches above prefix matches.
+     *
+     * \param query the words to search for
+     * \param limit the maximum number of results, or -1 for all
+     */
+    QList<MDesktopEntry> search(const QString &query, int limit = -1) const;
+
+private:
+    Q_DISABLE_COPY(MDesktopEntrySearchIndex)
+    MDesktopEntrySearchIndexPrivate *const d_ptr;
+    Q_DECLARE_PRIVATE(MDesktopEntrySearchIndex)
+};
+
+#endif /* MDESKTOPENTRYSEARCHINDEX_H_ */
@@ -0,0 +1,53 @@
+/***************************************************************************
+** Copyright (C) 2026 Jolla Ltd.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef MDESKTOPENTRYSEARCHINDEX_P_H
+#define MDESKTOPENTRYSEARCHINDEX_P_H
+
+#include <QHash>
+#include <QMap>
+#include <QStringList>
+#include <QVector>
+
+#include "mdesktopentry.h"
+
+class MDesktopEntrySearchIndexPrivate
+{
+public:
+    struct Posting
+    {
+        int document;
+        int weight;
+    };
+
+    struct Document
+    {
+        MDesktopEntry entry;
+        //! The case folded name, for ordering equally ranked results.
+        QString sortName;
+        //! The words this document has postings for.
+        QStringList words;
+    };
+
+    static QStringList words(const QString &text);
+
+    void add(int document, const QHash<QString, int> &weights);
+    void removeDocument(int document);
+
+    //! Postings by case folded word.
+    QMap<QString, QVector<Posting> > postings;
+    QVector<Document> documents;
+    //! Indices of unused documents, reused by later insertions.
+    QVector<int> freeDocuments;
+    QHash<QString, int> documentsByFileName;
+};
+
+#endif /* MDESKTOPENTRYSEARCHINDEX_P_H */
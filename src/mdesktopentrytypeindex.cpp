@@ -0,0 +1,165 @@
+/***************************************************************************
+** Copyright (C) 2026 Jolla Ltd.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#include "mdesktopentry.h"
+#include "mdesktopentrytypeindex.h"
+#include "mdesktopentrytypeindex_p.h"
+
+namespace {
+QStringList normalizedMimeTypes(const QStringList &mimeTypes)
+{
+    QStringList result;
+    result.reserve(mimeTypes.count());
+    for (const QString &mimeType : mimeTypes) {
+        const QString normalized = mimeType.trimmed().toLower();
+        if (!normalized.isEmpty())
+            result.append(normalized);
+    }
+    result.removeDuplicates();
+    return result;
+}
+}
+
+int MDesktopEntryTypeIndexPrivate::indexOf(const EntryList &entries, const QString &fileName)
+{
+    for (int i = 0; i < entries.count(); ++i) {
+        if (entries.at(i).fileName() == fileName)
+            return i;
+    }
+    return -1;
+}
+
+void MDesktopEntryTypeIndexPrivate::add(QHash<QString, EntryList> *index, const QStringList &keys,
+                                        const MDesktopEntry &entry)
+{
+    for (const QString &key : keys)
+        (*index)[key].append(entry);
+}
+
+void MDesktopEntryTypeIndexPrivate::remove(QHash<QString, EntryList> *index, const QStringList &keys,
+                                           const QString &fileName)
+{
+    for (const QString &key : keys) {
+        QHash<QString, EntryList>::iterator it = index->find(key);
+        if (it == index->end())
+            continue;
+
+        const int i = indexOf(it.value(), fileName);
+        if (i >= 0)
+            it.value().removeAt(i);
+        if (it.value().isEmpty())
+            index->erase(it);
+    }
+}
+
+MDesktopEntryTypeIndex::MDesktopEntryTypeIndex()
+    : d_ptr(new MDesktopEntryTypeIndexPrivate)
+{
+}
+
+MDesktopEntryTypeIndex::~MDesktopEntryTypeIndex()
+{
+    delete d_ptr;
+}
+
+void MDesktopEntryTypeIndex::insert(const MDesktopEntry &entry)
+{
+    Q_D(MDesktopEntryTypeIndex);
+
+    if (entry.fileName().isEmpty())
+        return;
+
+    remove(entry.fileName());
+
+    MDesktopEntryTypeIndexPrivate::Document document;
+    document.entry = entry;
+    document.mimeTypes = normalizedMimeTypes(entry.mimeType());
+    document.categories = entry.categories();
+    document.categories.removeAll(QString());
+    document.categories.removeDuplicates();
+
+    d->add(&d->entriesByMimeType, document.mimeTypes, entry);
+    d->add(&d->entriesByCategory, document.categories, entry);
+    d->documents.insert(entry.fileName(), document);
+}
+
+void MDesktopEntryTypeIndex::remove(const QString &fileName)
+{
+    Q_D(MDesktopEntryTypeIndex);
+
+    QHash<QString, MDesktopEntryTypeIndexPrivate::Document>::iterator it = d->documents.find(fileName);
+    if (it == d->documents.end())
+        return;
+
+    d->remove(&d->entriesByMimeType, it->mimeTypes, fileName);
+    d->remove(&d->entriesByCategory, it->categories, fileName);
+    d->documents.erase(it);
+}
+
+void MDesktopEntryTypeIndex::clear()
+{
+    Q_D(MDesktopEntryTypeIndex);
+
+    d->documents.clear();
+    d->entriesByMimeType.clear();
+    d->entriesByCategory.clear();
+}
+
+int MDesktopEntryTypeIndex::count() const
+{
+    Q_D(const MDesktopEntryTypeIndex);
+    return d->documents.count();
+}
+
+QList<MDesktopEntry> MDesktopEntryTypeIndex::entriesForMimeType(const QString &mimeType) const
+{
+    Q_D(const MDesktopEntryTypeIndex);
+
+    const QString normalized = mimeType.trimmed().toLower();
+    MDesktopEntryTypeIndexPrivate::EntryList result = d->entriesByMimeType.value(normalized);
+
+    const int separator = normalized.indexOf(QLatin1Char('/'));
+    if (separator <= 0 || normalized.endsWith(QLatin1Char('*')))
+        return result;
+
+    const QString wildcard = normalized.left(separator + 1) + QLatin1Char('*');
+    QHash<QString, MDesktopEntryTypeIndexPrivate::EntryList>::const_iterator it
+            = d->entriesByMimeType.constFind(wildcard);
+    if (it == d->entriesByMimeType.constEnd())
+        return result;
+
+    if (result.isEmpty())
+        return it.value();
+
+    for (const MDesktopEntry &entry : it.value()) {
+        if (d->indexOf(result, entry.fileName()) < 0)
+            result.append(entry);
+    }
+    return result;
+}
+
+QList<MDesktopEntry> MDesktopEntryTypeIndex::entriesInCategory(const QString &category) const
+{
+    Q_D(const MDesktopEntryTypeIndex);
+    return d->entriesByCategory.value(category);
+}
+
+QStringList MDesktopEntryTypeIndex::mimeTypes() const
+{
+    Q_D(const MDesktopEntryTypeIndex);
+    return d->entriesByMimeType.keys();
+}
+
+QStringList MDesktopEntryTypeIndex::categories() const
+{
+    Q_D(const MDesktopEntryTypeIndex);
+    return d->entriesByCategory.keys();
+}
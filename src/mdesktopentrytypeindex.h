@@ -0,0 +1,96 @@
+/***************************************************************************
+** Copyright (C) 2026 Jolla Ltd.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef MDESKTOPENTRYTYPEINDEX_H_
+#define MDESKTOPENTRYTYPEINDEX_H_
+
+#include <mlite-global.h>
+#include <QList>
+#include <QStringList>
+
+class MDesktopEntry;
+class MDesktopEntryTypeIndexPrivate;
+
+/*!
+ * MDesktopEntryTypeIndex maps MIME types and categories to the desktop
+ * entries declaring them.
+ *
+ * The MimeType and Categories keys of each entry are read once when it is
+ * inserted, after which finding the applications handling a MIME type or
+ * belonging to a category is a hash lookup. Entries can be inserted and
+ * removed at any time, for example from the signals of
+ * MDesktopEntryWatcher.
+ */
+class MLITESHARED_EXPORT MDesktopEntryTypeIndex
+{
+public:
+    /*!
+     * Constructs an empty index.
+     */
+    MDesktopEntryTypeIndex();
+
+    /*!
+     * Destroys the MDesktopEntryTypeIndex.
+     */
+    ~MDesktopEntryTypeIndex();
+
+    /*!
+     * Adds \a entry to the index, replacing an entry with the same file name.
+     * Entries without a file name are ignored.
+     */
+    void insert(const MDesktopEntry &entry);
+
+    /*!
+     * Removes the entry read from \a fileName from the index.
+     */
+    void remove(const QString &fileName);
+
+    /*!
+     * Removes all entries from the index.
+     */
+    void clear();
+
+    /*!
+     * Returns the number of entries in the index.
+     */
+    int count() const;
+
+    /*!
+     * Returns the entries declaring \a mimeType in their MimeType key, in
+     * insertion order. MIME types are compared case insensitively, and
+     * entries declaring the wildcard type of the same media type, such as
+     * "image/*" for "image/jpeg", are returned after the exact matches.
+     */
+    QList<MDesktopEntry> entriesForMimeType(const QString &mimeType) const;
+
+    /*!
+     * Returns the entries listing \a category in their Categories key, in
+     * insertion order.
+     */
+    QList<MDesktopEntry> entriesInCategory(const QString &category) const;
+
+    /*!
+     * Returns the MIME types declared by the indexed entries, in lower case.
+     */
+    QStringList mimeTypes() const;
+
+    /*!
+     * Returns the categories listed by the indexed entries.
+     */
+    QStringList categories() const;
+
+private:
+    Q_DISABLE_COPY(MDesktopEntryTypeIndex)
+    MDesktopEntryTypeIndexPrivate *const d_ptr;
+    Q_DECLARE_PRIVATE(MDesktopEntryTypeIndex)
+};
+
+#endif /* MDESKTOPENTRYTYPEINDEX_H_ */
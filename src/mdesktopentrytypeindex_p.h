@@ -0,0 +1,45 @@
+/***************************************************************************
+** Copyright (C) 2026 Jolla Ltd.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef MDESKTOPENTRYTYPEINDEX_P_H
+#define MDESKTOPENTRYTYPEINDEX_P_H
+
+#include <QHash>
+#include <QList>
+#include <QStringList>
+
+#include "mdesktopentry.h"
+
+class MDesktopEntryTypeIndexPrivate
+{
+public:
+    typedef QList<MDesktopEntry> EntryList;
+
+    struct Document
+    {
+        MDesktopEntry entry;
+        //! The lower case MIME types the entry was added under.
+        QStringList mimeTypes;
+        QStringList categories;
+    };
+
+    static int indexOf(const EntryList &entries, const QString &fileName);
+    static void add(QHash<QString, EntryList> *index, const QStringList &keys,
+                    const MDesktopEntry &entry);
+    static void remove(QHash<QString, EntryList> *index, const QStringList &keys,
+                       const QString &fileName);
+
+    QHash<QString, Document> documents;
+    QHash<QString, EntryList> entriesByMimeType;
+    QHash<QString, EntryList> entriesByCategory;
+};
+
+#endif /* MDESKTOPENTRYTYPEINDEX_P_H */
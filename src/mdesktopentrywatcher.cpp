@@ -0,0 +1,412 @@
+/***************************************************************************
+** Copyright (C) 2026 Jolla Ltd.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QEvent>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QSocketNotifier>
+#include <QThreadPool>
+#include <QVector>
+
+#include <algorithm>
+
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include "mdesktopentry.h"
+#include "mdesktopentrywatcher.h"
+#include "mdesktopentrywatcher_p.h"
+#include "logging.h"
+
+namespace {
+const QString DesktopFilePattern = QStringLiteral("*.desktop");
+const QString DesktopFileSuffix = QStringLiteral(".desktop");
+const int DefaultCoalesceInterval = 200;
+const uint32_t DirectoryMask = IN_CREATE | IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE
+        | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+// Added to the mask of a directory which may also be watched itself.
+const uint32_t AncestorMask = IN_CREATE | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR | IN_MASK_ADD;
+
+typedef QVector<QPair<QString, MDesktopEntry> > ReadResults;
+
+class ReadEvent : public QEvent
+{
+public:
+    enum { TYPE = QEvent::User };
+
+    explicit ReadEvent(const ReadResults &results) : QEvent(Type(TYPE)), results(results) {}
+
+    ReadResults results;
+};
+
+// Reads changed files on the thread pool, an entry without a file marks a removed file.
+class ReadJob : public QRunnable
+{
+public:
+    ReadJob(const QStringList &fileNames, const QSharedPointer<MDesktopEntryWatcherPrivate::Guard> &guard)
+        : m_fileNames(fileNames)
+        , m_guard(guard)
+    {
+    }
+
+    void run()
+    {
+        QStringList existing;
+        for (const QString &fileName : m_fileNames) {
+            if (QFileInfo(fileName).isFile())
+                existing.append(fileName);
+        }
+
+        const QList<MDesktopEntry> entries = MDesktopEntry::loadAll(existing);
+
+        ReadResults results;
+        results.reserve(m_fileNames.count());
+        for (int i = 0, j = 0; i < m_fileNames.count(); ++i) {
+            if (j < existing.count() && existing.at(j) == m_fileNames.at(i))
+                results.append(qMakePair(m_fileNames.at(i), entries.at(j++)));
+            else
+                results.append(qMakePair(m_fileNames.at(i), MDesktopEntry()));
+        }
+
+        QMutexLocker locker(&m_guard->mutex);
+        if (m_guard->watcher)
+            QCoreApplication::postEvent(m_guard->watcher, new ReadEvent(results));
+    }
+
+private:
+    QStringList m_fileNames;
+    QSharedPointer<MDesktopEntryWatcherPrivate::Guard> m_guard;
+};
+
+QStringList desktopFiles(const QString &directory)
+{
+    QStringList fileNames;
+    const QFileInfoList files = QDir(directory).entryInfoList(QStringList(DesktopFilePattern), QDir::Files);
+    for (const QFileInfo &file : files)
+        fileNames.append(file.absoluteFilePath());
+    return fileNames;
+}
+}
+
+MDesktopEntryWatcherPrivate::MDesktopEntryWatcherPrivate(MDesktopEntryWatcher *q)
+    : q_ptr(q)
+    , notifier(0)
+    , guard(new Guard)
+    , inotifyFd(inotify_init1(IN_NONBLOCK | IN_CLOEXEC))
+    , reading(false)
+{
+    guard->watcher = this;
+
+    coalesceTimer.setSingleShot(true);
+    coalesceTimer.setInterval(DefaultCoalesceInterval);
+    connect(&coalesceTimer, &QTimer::timeout, this, &MDesktopEntryWatcherPrivate::startRead);
+
+    if (inotifyFd < 0) {
+        qCWarning(lcMlite) << "Could not create inotify instance:" << strerror(errno);
+        return;
+    }
+
+    notifier = new QSocketNotifier(inotifyFd, QSocketNotifier::Read, this);
+    connect(notifier, &QSocketNotifier::activated, this, &MDesktopEntryWatcherPrivate::readEvents);
+}
+
+MDesktopEntryWatcherPrivate::~MDesktopEntryWatcherPrivate()
+{
+    {
+        QMutexLocker locker(&guard->mutex);
+        guard->watcher = 0;
+    }
+
+    delete notifier;
+    if (inotifyFd >= 0)
+        close(inotifyFd);
+}
+
+bool MDesktopEntryWatcherPrivate::addWatch(const QString &directory)
+{
+    if (inotifyFd < 0)
+        return false;
+
+    const int watch = inotify_add_watch(inotifyFd, QFile::encodeName(directory).constData(), DirectoryMask);
+    if (watch < 0) {
+        if (errno != ENOENT && errno != ENOTDIR)
+            qCWarning(lcMlite) << "Could not watch desktop entry directory" << directory << strerror(errno);
+        // Watched once it's created again.
+        missing.insert(directory);
+        watchAncestor(directory);
+        return false;
+    }
+    missing.remove(directory);
+    watches.insert(watch, directory);
+    return true;
+}
+
+void MDesktopEntryWatcherPrivate::removeWatch(const QString &directory)
+{
+    missing.remove(directory);
+    for (QHash<int, QString>::iterator it = watches.begin(); it != watches.end();) {
+        if (it.value() == directory) {
+            if (!ancestorWatches.contains(it.key()))
+                inotify_rm_watch(inotifyFd, it.key());
+            it = watches.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void MDesktopEntryWatcherPrivate::watchAncestor(const QString &directory)
+{
+    for (QString ancestor = QFileInfo(directory).path(); ; ancestor = QFileInfo(ancestor).path()) {
+        const int watch = inotify_add_watch(inotifyFd, QFile::encodeName(ancestor).constData(), AncestorMask);
+        if (watch >= 0) {
+            ancestorWatches.insert(watch, ancestor);
+            return;
+        }
+        if (ancestor == QFileInfo(ancestor).path())
+            return;
+    }
+}
+
+void MDesktopEntryWatcherPrivate::watchMissing()
+{
+    // Start over, the nearest existing ancestors may have changed.
+    for (QHash<int, QString>::const_iterator it = ancestorWatches.constBegin(); it != ancestorWatches.constEnd(); ++it) {
+        if (!watches.contains(it.key()))
+            inotify_rm_watch(inotifyFd, it.key());
+    }
+    ancestorWatches.clear();
+
+    const QSet<QString> directories = missing;
+    missing.clear();
+    for (const QString &directory : directories) {
+        if (addWatch(directory))
+            rescan(directory);
+    }
+}
+
+void MDesktopEntryWatcherPrivate::rescan(const QString &directory)
+{
+    // Known files which no longer exist are read as removed.
+    const QString prefix = directory + QLatin1Char('/');
+    for (QMap<QString, MDesktopEntry>::const_iterator it = entries.lowerBound(prefix);
+            it != entries.constEnd() && it.key().startsWith(prefix);
+            ++it) {
+        if (it.key().indexOf(QLatin1Char('/'), prefix.length()) < 0)
+            pending.insert(it.key());
+    }
+    for (const QString &fileName : desktopFiles(directory))
+        pending.insert(fileName);
+}
+
+void MDesktopEntryWatcherPrivate::readEvents()
+{
+    // Large enough for several events with a name of NAME_MAX bytes.
+    alignas(inotify_event) char buffer[4 * (sizeof(inotify_event) + NAME_MAX + 1)];
+    bool ancestorsChanged = false;
+
+    for (;;) {
+        const ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+        if (length <= 0)
+            break;
+
+        for (const char *p = buffer; p < buffer + length;) {
+            const inotify_event *event = reinterpret_cast<const inotify_event *>(p);
+            p += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                qCDebug(lcMlite) << "Desktop entry watcher queue overflow, rescanning";
+                for (const QString &directory : directories)
+                    rescan(directory);
+                continue;
+            }
+
+            // A directory appeared in, or the ancestor of a missing directory went away.
+            if (ancestorWatches.contains(event->wd)
+                    && (event->mask & (IN_ISDIR | IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF))) {
+                ancestorsChanged = true;
+            }
+
+            const QString directory = watches.value(event->wd);
+            if (directory.isEmpty())
+                continue;
+
+            if (event->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF)) {
+                // The directory is gone, so are its entries. It's watched again once it's back.
+                removeWatch(directory);
+                rescan(directory);
+                missing.insert(directory);
+                ancestorsChanged = true;
+                continue;
+            }
+
+            if (event->len > 0) {
+                const QString name = QFile::decodeName(event->name);
+                if (name.endsWith(DesktopFileSuffix))
+                    pending.insert(directory + QLatin1Char('/') + name);
+            }
+        }
+    }
+
+    if (ancestorsChanged)
+        watchMissing();
+
+    // The interval isn't restarted by later events, so a steady stream of changes can't
+    // postpone the update indefinitely.
+    if (!pending.isEmpty() && !reading && !coalesceTimer.isActive())
+        coalesceTimer.start();
+}
+
+void MDesktopEntryWatcherPrivate::startRead()
+{
+    if (reading || pending.isEmpty())
+        return;
+
+    QStringList fileNames = pending.values();
+    std::sort(fileNames.begin(), fileNames.end());
+    pending.clear();
+
+    reading = true;
+    QThreadPool::globalInstance()->start(new ReadJob(fileNames, guard));
+}
+
+void MDesktopEntryWatcherPrivate::customEvent(QEvent *event)
+{
+    Q_Q(MDesktopEntryWatcher);
+
+    if (event->type() != (QEvent::Type)ReadEvent::TYPE)
+        return;
+
+    reading = false;
+
+    const ReadResults &results = static_cast<ReadEvent *>(event)->results;
+    for (const QPair<QString, MDesktopEntry> &result : results) {
+        const QString &fileName = result.first;
+        if (!directories.contains(QFileInfo(fileName).absolutePath()))
+            continue;
+
+        if (result.second.fileName().isEmpty()) {
+            if (entries.remove(fileName) > 0)
+                emit q->entryRemoved(fileName);
+        } else if (entries.contains(fileName)) {
+            entries.insert(fileName, result.second);
+            emit q->entryChanged(fileName);
+        } else {
+            entries.insert(fileName, result.second);
+            emit q->entryAdded(fileName);
+        }
+    }
+
+    if (!pending.isEmpty() && !coalesceTimer.isActive())
+        coalesceTimer.start();
+}
+
+MDesktopEntryWatcher::MDesktopEntryWatcher(QObject *parent)
+    : QObject(parent)
+    , d_ptr(new MDesktopEntryWatcherPrivate(this))
+{
+}
+
+MDesktopEntryWatcher::MDesktopEntryWatcher(const QStringList &directories, QObject *parent)
+    : QObject(parent)
+    , d_ptr(new MDesktopEntryWatcherPrivate(this))
+{
+    setDirectories(directories);
+}
+
+MDesktopEntryWatcher::~MDesktopEntryWatcher()
+{
+    delete d_ptr;
+}
+
+QStringList MDesktopEntryWatcher::directories() const
+{
+    Q_D(const MDesktopEntryWatcher);
+    return d->directories;
+}
+
+void MDesktopEntryWatcher::setDirectories(const QStringList &directories)
+{
+    Q_D(MDesktopEntryWatcher);
+
+    QStringList absoluteDirectories;
+    for (const QString &directory : directories) {
+        const QString absolute = QDir(directory).absolutePath();
+        if (!absoluteDirectories.contains(absolute))
+            absoluteDirectories.append(absolute);
+    }
+
+    if (absoluteDirectories == d->directories)
+        return;
+
+    for (const QString &directory : d->directories) {
+        if (absoluteDirectories.contains(directory))
+            continue;
+
+        d->removeWatch(directory);
+        const QString prefix = directory + QLatin1Char('/');
+        for (QMap<QString, MDesktopEntry>::iterator it = d->entries.lowerBound(prefix);
+                it != d->entries.end() && it.key().startsWith(prefix);) {
+            if (QFileInfo(it.key()).absolutePath() == directory)
+                it = d->entries.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    QStringList fileNames;
+    for (const QString &directory : absoluteDirectories) {
+        if (d->directories.contains(directory))
+            continue;
+
+        // Watch before listing, so no change between the two is missed.
+        d->addWatch(directory);
+        fileNames += desktopFiles(directory);
+    }
+
+    d->directories = absoluteDirectories;
+
+    const QList<MDesktopEntry> entries = MDesktopEntry::loadAll(fileNames);
+    for (int i = 0; i < fileNames.count(); ++i)
+        d->entries.insert(fileNames.at(i), entries.at(i));
+
+    emit directoriesChanged();
+}
+
+int MDesktopEntryWatcher::coalesceInterval() const
+{
+    Q_D(const MDesktopEntryWatcher);
+    return d->coalesceTimer.interval();
+}
+
+void MDesktopEntryWatcher::setCoalesceInterval(int interval)
+{
+    Q_D(MDesktopEntryWatcher);
+    d->coalesceTimer.setInterval(interval);
+}
+
+QStringList MDesktopEntryWatcher::fileNames() const
+{
+    Q_D(const MDesktopEntryWatcher);
+    return d->entries.keys();
+}
+
+MDesktopEntry MDesktopEntryWatcher::entry(const QString &fileName) const
+{
+    Q_D(const MDesktopEntryWatcher);
+    return d->entries.value(fileName);
+}
@@ -0,0 +1,109 @@
+/***************************************************************************
+** Copyright (C) 2026 Jolla Ltd.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef MDESKTOPENTRYWATCHER_H_
+#define MDESKTOPENTRYWATCHER_H_
+
+#include <mlite-global.h>
+#include <QObject>
+#include <QStringList>
+
+class MDesktopEntry;
+class MDesktopEntryWatcherPrivate;
+
+/*!
+ * MDesktopEntryWatcher keeps the desktop entries of a set of directories up
+ * to date.
+ *
+ * The directories are read when they are set, and watched with a single
+ * inotify instance afterwards. Changes are collected for coalesceInterval()
+ * milliseconds, so a package installation touching many files results in a
+ * single update, and the changed files are then parsed on the global
+ * QThreadPool. The entryAdded(), entryChanged() and entryRemoved() signals
+ * are emitted once the new entries are available from entry().
+ *
+ * A directory which doesn't exist, or is removed, is watched again once it
+ * is created.
+ */
+class MLITESHARED_EXPORT MDesktopEntryWatcher : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QStringList directories READ directories WRITE setDirectories NOTIFY directoriesChanged)
+    Q_PROPERTY(int coalesceInterval READ coalesceInterval WRITE setCoalesceInterval)
+
+public:
+    /*!
+     * Constructs a watcher which doesn't watch any directories.
+     */
+    explicit MDesktopEntryWatcher(QObject *parent = 0);
+
+    /*!
+     * Constructs a watcher and reads the desktop entries in \a directories.
+     */
+    explicit MDesktopEntryWatcher(const QStringList &directories, QObject *parent = 0);
+
+    /*!
+     * Destroys the MDesktopEntryWatcher.
+     */
+    virtual ~MDesktopEntryWatcher();
+
+    /*!
+     * Returns the watched directories.
+     */
+    QStringList directories() const;
+
+    /*!
+     * Sets the watched directories. The desktop entries of new directories
+     * are read in parallel before this returns, without emitting entryAdded(),
+     * and entries of directories no longer watched are dropped without
+     * emitting entryRemoved().
+     */
+    void setDirectories(const QStringList &directories);
+
+    /*!
+     * Returns the time in milliseconds changes are collected for before the
+     * changed files are read. The default is 200 ms.
+     */
+    int coalesceInterval() const;
+    void setCoalesceInterval(int interval);
+
+    /*!
+     * Returns the absolute paths of the desktop entry files in the watched
+     * directories.
+     */
+    QStringList fileNames() const;
+
+    /*!
+     * Returns the desktop entry for \a fileName, or an invalid entry without
+     * a file if the file isn't in a watched directory.
+     */
+    MDesktopEntry entry(const QString &fileName) const;
+
+signals:
+    void directoriesChanged();
+
+    //! Emitted when a desktop entry file was added to a watched directory.
+    void entryAdded(const QString &fileName);
+
+    //! Emitted when a desktop entry file was changed, entry() returns a new entry.
+    void entryChanged(const QString &fileName);
+
+    //! Emitted when a desktop entry file was removed from a watched directory.
+    void entryRemoved(const QString &fileName);
+
+private:
+    Q_DISABLE_COPY(MDesktopEntryWatcher)
+    MDesktopEntryWatcherPrivate *const d_ptr;
+    Q_DECLARE_PRIVATE(MDesktopEntryWatcher)
+    friend class MDesktopEntryWatcherPrivate;
+};
+
+#endif /* MDESKTOPENTRYWATCHER_H_ */
@@ -0,0 +1,72 @@
+/***************************************************************************
+** Copyright (C) 2026 Jolla Ltd.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef MDESKTOPENTRYWATCHER_P_H
+#define MDESKTOPENTRYWATCHER_P_H
+
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QTimer>
+
+#include "mdesktopentry.h"
+
+class MDesktopEntryWatcher;
+class QSocketNotifier;
+
+class MDesktopEntryWatcherPrivate : public QObject
+{
+public:
+    //! Lets a read job deliver its results only while the watcher exists.
+    struct Guard
+    {
+        QMutex mutex;
+        MDesktopEntryWatcherPrivate *watcher;
+    };
+
+    explicit MDesktopEntryWatcherPrivate(MDesktopEntryWatcher *q);
+    ~MDesktopEntryWatcherPrivate();
+
+    void customEvent(QEvent *event);
+
+    void readEvents();
+    bool addWatch(const QString &directory);
+    void removeWatch(const QString &directory);
+    void watchAncestor(const QString &directory);
+    void watchMissing();
+    void rescan(const QString &directory);
+    void startRead();
+
+    MDesktopEntryWatcher *q_ptr;
+    QStringList directories;
+    QMap<QString, MDesktopEntry> entries;
+    //! Watched directories by inotify watch descriptor.
+    QHash<int, QString> watches;
+    //! Directories which don't exist, waited for through their nearest existing ancestor.
+    QSet<QString> missing;
+    //! The ancestors of the missing directories by inotify watch descriptor.
+    QHash<int, QString> ancestorWatches;
+    //! Files which changed since the last read was started.
+    QSet<QString> pending;
+    QTimer coalesceTimer;
+    QSocketNotifier *notifier;
+    QSharedPointer<Guard> guard;
+    int inotifyFd;
+    bool reading;
+
+    Q_DECLARE_PUBLIC(MDesktopEntryWatcher)
+};
+
+#endif /* MDESKTOPENTRYWATCHER_P_H */
@@ -18,147 +18,146 @@
 ****************************************************************************/
 #include "mfiledatastore.h"
 #include "mfiledatastore_p.h"
-#include <QTemporaryFile>
+#include "mfilewatcher_p.h"
 #include <QFileInfo>
+#include <algorithm>
 
 /*!
- * Creates a temporary file in the directory of an original file.
- * \param originalPath Absolute path that is used as a base for generating
- * the temporary file.
- * \return Path of the created file, or an empty string if creating the
- * file fails. The returned value is a copy, so for uses where it's assigned
- * to a variable, it need not be const. For cases where it's passed as a
- * parameter, it need not be const because references to non-const will
- * not bind to function return values, because they are rvalues. When
- * C++0x brings rvalue references, the value should not be const in order
- * to allow rvalue references to bind to it and thus enable moving from it.
+ * Makes the process wide file watcher notify a data store of changes to its file.
+ * Called again after writing the file, in case its directory has been created.
+ * \param filePath Path (including name) of the file to watch.
+ * \param store The data store to notify.
  */
-static QString createTempFile(const QString &originalPath)
+static void watchFile(const QString &filePath, MFileDataStore *store)
 {
-    QString returnValue;
-    QTemporaryFile tempFile(originalPath);
-    if (tempFile.open()) {
-        tempFile.setAutoRemove(false);
-        returnValue = tempFile.fileName();
-    }
-    return returnValue;
+    if (MFileWatcher *watcher = MFileWatcher::instance())
+        watcher->addFile(filePath, store);
 }
 
-/*!
- * Copies settings from a QSettings object to another QSettings object.
- * \param originalSettings Settings to copy.
- * \param newSettings Target of the copy.
- * \return true if copying succeeds, false if it fails.
- */
-static bool copySettings(const QSettings &originalSettings,
-                         QSettings &newSettings)
+MFileDataStorePrivate::FileStamp MFileDataStorePrivate::FileStamp::of(const QString &filePath)
 {
-    QStringList keys = originalSettings.allKeys();
-    foreach (const QString & key, originalSettings.allKeys()) {
-        newSettings.setValue(key, originalSettings.value(key));
-        if (newSettings.status() != QSettings::NoError) {
-            return false;
-        }
+    const QFileInfo info(filePath);
+    FileStamp stamp;
+    stamp.exists = info.exists();
+    if (stamp.exists) {
+        stamp.size = info.size();
+        stamp.modified = info.lastModified();
     }
-    return true;
+    return stamp;
 }
 
-/*!
- * Renames a file. Ensures that a file with the new name
- * doesn't exist.
- * \param oldname Name of the file to rename.
- * \param newName New name.
- */
-static void renameSettingFile(const QString &oldName,
-                              const QString &newName)
+bool MFileDataStorePrivate::FileStamp::operator==(const FileStamp &other) const
 {
-    QFile::remove(newName);
-    QFile::rename(oldName, newName);
+    return exists == other.exists && size == other.size && modified == other.modified;
 }
 
-/*!
- * Adds the necessary paths to the file system watcher
- * \param filePath Path (including name) of the file to watch.
- * \param watcher The file system watcher.
- */
-static void addPathsToWatcher(const QString &filePath,
-                              QScopedPointer<QFileSystemWatcher>& watcher)
+MFileDataStorePrivate::MFileDataStorePrivate(const QString &filePath, MFileDataStore *q)
+    : q_ptr(q)
+    , settings(createSettings(filePath))
+    , externalChanges(false)
+    , flushDelay(-1)
+    , batchDepth(0)
+    , dirty(false)
 {
-    QFileInfo fileInfo(filePath);
-    QString directory;
-    bool fileExists = fileInfo.exists();
-    if (fileExists) {
-        // If the file exists, we can take the canonical path directly
-        directory = fileInfo.canonicalPath();
-    } else {
-        // If the file doesn't exist, canonicalPath would return an empty string. That's why
-        // we need to get the parent directory first.
-        QFileInfo parentPath(fileInfo.absolutePath());
-        if (parentPath.exists()) {
-            directory = parentPath.canonicalFilePath();
-        }
-    }
+    flushTimer.setSingleShot(true);
+    settings->sync();
+    updateFileStamp();
+}
 
-    if (!directory.isEmpty()) {
-        // Watch the directory if it's not being watched yet
-        if (!watcher->directories().contains(directory)) {
-            watcher->addPath(directory);
-        }
+QSettings *MFileDataStorePrivate::createSettings(const QString &filePath)
+{
+    QSettings *settings = new QSettings(filePath, QSettings::IniFormat);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+    // Never fall back to truncating and rewriting the file in place.
+    settings->setAtomicSyncRequired(true);
+#endif
+    return settings;
+}
+
+bool MFileDataStorePrivate::sync()
+{
+    // Saving merges changes made by others since the file was last read,
+    // those still need to be signaled when the watcher notices them.
+    if (FileStamp::of(settings->fileName()) != fileStamp)
+        externalChanges = true;
+
+    // QSettings serializes the settings once into a temporary file in the
+    // same directory, flushes it to disk and renames it over the original,
+    // so the original stays intact when there's no disk space.
+    settings->sync();
+    watchFile(settings->fileName(), q_ptr);
+    updateFileStamp();
+    if (settings->status() == QSettings::NoError)
+        return true;
+
+    resetSettings();
+    return false;
+}
+
+void MFileDataStorePrivate::resetSettings()
+{
+    // QSettings keeps reporting its first error for good, so a failed sync would make the
+    // store unusable. Continue with fresh settings holding the same values instead.
+    QScopedPointer<QSettings> fresh(createSettings(settings->fileName()));
+
+    const QStringList keys = fresh->allKeys();
+    for (const QString &key : keys) {
+        if (!settings->contains(key))
+            fresh->remove(key);
     }
 
-    // Watch the file itself if it's not being watched yet
-    if (fileExists && !watcher->files().contains(filePath)) {
-        watcher->addPath(filePath);
+    const QStringList unsaved = settings->allKeys();
+    for (const QString &key : unsaved) {
+        const QVariant value = settings->value(key);
+        if (!fresh->contains(key) || fresh->value(key) != value)
+            fresh->setValue(key, value);
     }
+
+    settings.swap(fresh);
 }
 
-/*!
- * Saves the settings to a file. The settings are first
- * saved to a temporary file, and then that file is copied
- * over the original settings. This avoids clearing settings
- * when there's no disk space.
- * \param originalSettings Settings to save.
- */
-static bool doSync(QSettings &originalSettings, QScopedPointer<QFileSystemWatcher>& watcher)
+void MFileDataStorePrivate::updateFileStamp()
 {
-    bool returnValue = false;
-    QString tempFileName = createTempFile(originalSettings.fileName());
-    if (!tempFileName.isEmpty()) {
-        QSettings copiedSettings(tempFileName, QSettings::IniFormat);
-        if (copySettings(originalSettings, copiedSettings)) {
-            copiedSettings.sync();
-            if (copiedSettings.status() == QSettings::NoError) {
-                renameSettingFile(tempFileName, originalSettings.fileName());
-                originalSettings.sync();
-                returnValue = true;
-            }
-        }
-    }
-    addPathsToWatcher(originalSettings.fileName(), watcher);
-    return returnValue;
+    fileStamp = FileStamp::of(settings->fileName());
+}
+
+QMap<QString, QVariant> MFileDataStorePrivate::readValues() const
+{
+    QStringList keys = settings->allKeys();
+    std::sort(keys.begin(), keys.end());
+
+    QMap<QString, QVariant> values;
+    for (const QString &key : keys)
+        values.insert(values.constEnd(), key, settings->value(key));
+    return values;
 }
 
-MFileDataStorePrivate::MFileDataStorePrivate(const QString &filePath)
-    : settings(filePath, QSettings::IniFormat)
-    , watcher(new QFileSystemWatcher())
+bool MFileDataStorePrivate::write()
 {
-    settings.sync();
+    if (!isDeferred())
+        return sync();
+
+    dirty = true;
+    if (batchDepth == 0)
+        flushTimer.start(flushDelay);
+    return true;
 }
 
 MFileDataStore::MFileDataStore(const QString &filePath)
-    : d_ptr(new MFileDataStorePrivate(filePath))
+    : d_ptr(new MFileDataStorePrivate(filePath, this))
 {
     Q_D(MFileDataStore);
     takeSnapshot();
-    addPathsToWatcher(filePath, d->watcher);
-    connect(d->watcher.data(), SIGNAL(fileChanged(QString)),
-            this, SLOT(fileChanged(QString)));
-    connect(d->watcher.data(), SIGNAL(directoryChanged(QString)),
-            this, SLOT(directoryChanged(QString)));
+    watchFile(d->settings->fileName(), this);
+    connect(&d->flushTimer, SIGNAL(timeout()), this, SLOT(flush()));
 }
 
 MFileDataStore::~MFileDataStore()
 {
+    Q_D(MFileDataStore);
+    flush();
+    if (MFileWatcher *watcher = MFileWatcher::instance())
+        watcher->removeFile(d->settings->fileName(), this);
     delete d_ptr;
 }
 
@@ -169,10 +168,10 @@ bool MFileDataStore::createValue(const QString &key, const QVariant &value)
     // QSettings has some kind of a cache so we'll prevent any temporary writes
     // by checking if the data can be actually stored before doing anything
     if (isWritable()) {
-        bool originalValueSet = d->settings.contains(key);
-        QVariant originalValue = d->settings.value(key);
-        d->settings.setValue(key, value);
-        bool syncOk = doSync(d->settings, d->watcher);
+        bool originalValueSet = d->settings->contains(key);
+        QVariant originalValue = d->settings->value(key);
+        d->settings->setValue(key, value);
+        bool syncOk = d->write();
         if (syncOk) {
             returnValue = true;
             // Emit valueChanged signal when value is changed or a new key is added
@@ -183,9 +182,9 @@ bool MFileDataStore::createValue(const QString &key, const QVariant &value)
             }
         } else if (originalValueSet) {
             // if sync fails, make sure the value in memory is the original
-            d->settings.setValue(key, originalValue);
+            d->settings->setValue(key, originalValue);
         } else {
-            d->settings.remove(key);
+            d->settings->remove(key);
         }
 
     }
@@ -198,10 +197,10 @@ bool MFileDataStore::setValue(const QString &key, const QVariant &value)
     bool returnValue = false;
     // QSettings has some kind of a cache so we'll prevent any temporary writes
     // by checking if the data can be actually stored before doing anything
-    if (isWritable() && d->settings.contains(key)) {
-        QVariant originalValue = d->settings.value(key);
-        d->settings.setValue(key, value);
-        bool syncOk = doSync(d->settings, d->watcher);
+    if (isWritable() && d->settings->contains(key)) {
+        QVariant originalValue = d->settings->value(key);
+        d->settings->setValue(key, value);
+        bool syncOk = d->write();
         if (syncOk) {
             returnValue = true;
             // Emit valueChanged signal when value is changed
@@ -211,7 +210,7 @@ bool MFileDataStore::setValue(const QString &key, const QVariant &value)
             }
         } else {
             // if sync fails, make sure the value in memory is the original
-            d->settings.setValue(key, originalValue);
+            d->settings->setValue(key, originalValue);
         }
     }
     return returnValue;
@@ -220,13 +219,13 @@ bool MFileDataStore::setValue(const QString &key, const QVariant &value)
 QVariant MFileDataStore::value(const QString &key) const
 {
     Q_D(const MFileDataStore);
-    return d->settings.value(key);
+    return d->settings->value(key);
 }
 
 QStringList MFileDataStore::allKeys() const
 {
     Q_D(const MFileDataStore);
-    return d->settings.allKeys();
+    return d->settings->allKeys();
 }
 
 void MFileDataStore::remove(const QString &key)
@@ -235,17 +234,17 @@ void MFileDataStore::remove(const QString &key)
     // QSettings has some kind of a cache so we'll prevent any temporary writes
     // by checking if the data can be actually stored before doing anything
     if (isWritable()) {
-        bool originalValueSet = d->settings.contains(key);
+        bool originalValueSet = d->settings->contains(key);
         if (!originalValueSet) {
             return;
         }
-        QVariant originalValue = d->settings.value(key);
-        d->settings.remove(key);
-        bool syncOk = doSync(d->settings, d->watcher);
+        QVariant originalValue = d->settings->value(key);
+        d->settings->remove(key);
+        bool syncOk = d->write();
         if (!syncOk) {
             if (originalValueSet) {
                 // if sync fails, make sure the value in memory is the original
-                d->settings.setValue(key, originalValue);
+                d->settings->setValue(key, originalValue);
             }
         } else {
             d->settingsSnapshot.remove(key);
@@ -260,8 +259,10 @@ void MFileDataStore::clear()
     // QSettings has some kind of a cache so we'll prevent any temporary writes
     // by checking if the data can be actually stored before doing anything
     if (isWritable()) {
-        d->settings.clear();
-        d->settings.sync();
+        d->settings->clear();
+        d->sync();
+        d->dirty = false;
+        d->flushTimer.stop();
         takeSnapshot();
     }
 }
@@ -269,63 +270,124 @@ void MFileDataStore::clear()
 bool MFileDataStore::contains(const QString &key) const
 {
     Q_D(const MFileDataStore);
-    return d->settings.contains(key);
+    return d->settings->contains(key);
 }
 
 bool MFileDataStore::isReadable() const
 {
     Q_D(const MFileDataStore);
-    return d->settings.status() == QSettings::NoError;
+    return d->settings->status() == QSettings::NoError;
 }
 
 bool MFileDataStore::isWritable() const
 {
     Q_D(const MFileDataStore);
-    return d->settings.isWritable() && d->settings.status() == QSettings::NoError;
+    return d->settings->isWritable() && d->settings->status() == QSettings::NoError;
 }
 
-void MFileDataStore::takeSnapshot()
+void MFileDataStore::setFlushDelay(int msec)
 {
     Q_D(MFileDataStore);
-    d->settingsSnapshot.clear();
-    foreach (const QString & key, d->settings.allKeys()) {
-        d->settingsSnapshot.insert(key, d->settings.value(key));
-    }
+    d->flushDelay = msec;
+    if (msec < 0 && d->batchDepth == 0)
+        flush();
+    else if (d->dirty && d->batchDepth == 0)
+        d->flushTimer.start(msec);
 }
 
-void MFileDataStore::fileChanged(const QString &fileName)
+int MFileDataStore::flushDelay() const
+{
+    Q_D(const MFileDataStore);
+    return d->flushDelay;
+}
+
+void MFileDataStore::beginBatch()
 {
     Q_D(MFileDataStore);
-    // sync the settings and add the path, for observing
-    // the file even if it was deleted
-    d->settings.sync();
-    addPathsToWatcher(d->settings.fileName(), d->watcher);
-    if (d->settings.fileName() == fileName && isWritable()) {
-        // Check whether the values for existing keys have changed or
-        // if keys have been deleted
-        foreach (const QString & key, d->settingsSnapshot.keys()) {
-            if ((d->settings.contains(key)
-                    && d->settings.value(key) != d->settingsSnapshot.value(key))
-                    || (!d->settings.contains(key))) {
-                emit valueChanged(key, d->settings.value(key));
-            }
-        }
-        // Check whether new keys have been added
-        foreach (const QString & key, d->settings.allKeys()) {
-            if (!d->settingsSnapshot.contains(key)) {
-                emit valueChanged(key, d->settings.value(key));
-            }
-        }
-        takeSnapshot();
-    }
+    ++d->batchDepth;
+    d->flushTimer.stop();
+}
+
+bool MFileDataStore::endBatch()
+{
+    Q_D(MFileDataStore);
+    if (d->batchDepth == 0 || --d->batchDepth > 0)
+        return true;
+
+    if (d->flushDelay < 0)
+        return flush();
+
+    if (d->dirty)
+        d->flushTimer.start(d->flushDelay);
+    return true;
+}
+
+bool MFileDataStore::flush()
+{
+    Q_D(MFileDataStore);
+    d->flushTimer.stop();
+    if (!d->dirty)
+        return true;
+
+    d->dirty = !d->sync();
+    return !d->dirty;
+}
+
+void MFileDataStore::takeSnapshot()
+{
+    Q_D(MFileDataStore);
+    d->settingsSnapshot = d->readValues();
 }
 
-void MFileDataStore::directoryChanged(const QString &fileName)
+void MFileDataStore::fileChanged(const QString &fileName)
 {
     Q_D(MFileDataStore);
-    if (fileName == QFileInfo(d->settings.fileName()).canonicalPath()) {
-        // we can't know which file changed, so we'll sync at this
-        // point. This is not very optimal, but it at least works.
-        fileChanged(d->settings.fileName());
+    // watch again in case the directory was replaced or deleted
+    watchFile(d->settings->fileName(), this);
+    if (d->settings->fileName() != fileName)
+        return;
+
+    if (!isWritable()) {
+        d->settings->sync();
+        d->updateFileStamp();
+        return;
+    }
+
+    // Skip our own writes. Like QSettings, which wouldn't reread the file either, a write
+    // which leaves the size and modification time as they were isn't told apart.
+    if (!d->externalChanges && MFileDataStorePrivate::FileStamp::of(fileName) == d->fileStamp)
+        return;
+    d->externalChanges = false;
+
+    // This also writes pending changes
+    d->settings->sync();
+    if (d->settings->status() != QSettings::NoError)
+        d->resetSettings();
+    d->dirty = false;
+    d->flushTimer.stop();
+    d->updateFileStamp();
+
+    // Walk the old and new values in key order to find the changed, removed and added keys.
+    // Slots may change the snapshot, so walk copies of it.
+    const QMap<QString, QVariant> previousValues = d->settingsSnapshot;
+    const QMap<QString, QVariant> values = d->readValues();
+    d->settingsSnapshot = values;
+
+    QMap<QString, QVariant>::const_iterator previous = previousValues.constBegin();
+    QMap<QString, QVariant>::const_iterator current = values.constBegin();
+    while (previous != previousValues.constEnd() || current != values.constEnd()) {
+        if (current == values.constEnd()
+                || (previous != previousValues.constEnd() && previous.key() < current.key())) {
+            emit valueChanged(previous.key(), QVariant());
+            ++previous;
+        } else if (previous == previousValues.constEnd() || current.key() < previous.key()) {
+            emit valueChanged(current.key(), current.value());
+            ++current;
+        } else {
+            if (current.value() != previous.value())
+                emit valueChanged(current.key(), current.value());
+            ++previous;
+            ++current;
+        }
     }
 }
@@ -93,6 +93,50 @@ public:
      */
     bool isWritable() const;
 
+    /*!
+     * Sets the time in milliseconds changes are kept in memory before they
+     * are written to the file. Each change restarts the delay, so a burst
+     * of changes is written at once when the store has been idle for
+     * \a msec. A delay of 0 writes after returning to the event loop, and
+     * a negative delay, the default, writes every change immediately.
+     *
+     * While changes are pending, \c value returns them and \c valueChanged
+     * is emitted for them, but other instances for the same file don't see
+     * them yet. A write which fails is not rolled back, \c flush returns
+     * \c false instead.
+     * \sa flush, beginBatch
+     */
+    void setFlushDelay(int msec);
+
+    /*!
+     * Returns the time in milliseconds changes are kept in memory before
+     * they are written, or a negative value if they are written immediately.
+     */
+    int flushDelay() const;
+
+    /*!
+     * Starts a batch of changes which are written to the file together
+     * when the matching \c endBatch is called. Batches may be nested.
+     * \sa endBatch
+     */
+    void beginBatch();
+
+    /*!
+     * Ends a batch started with \c beginBatch. Ending the outermost batch
+     * writes the changes made during it, or schedules them to be written
+     * after the flush delay if one is set.
+     * \return \c false if writing the changes failed.
+     */
+    bool endBatch();
+
+public slots:
+    /*!
+     * Writes pending changes to the file now. Pending changes are also
+     * written when the data store is destroyed.
+     * \return \c false if writing the changes failed.
+     */
+    bool flush();
+
 private:
     /*!
      * Takes a snapshot of keys and values in the underlying QSettings.
@@ -109,12 +153,6 @@ private slots:
      */
     void fileChanged(const QString &fileName);
 
-    /*!
-     * Notifies that the directory of the settings file has been changed in the filesystem externally
-     * \param fileName The name of the file modified
-     */
-    void directoryChanged(const QString &fileName);
-
 protected:
     MFileDataStorePrivate * const d_ptr;
 
@@ -20,24 +20,89 @@
 #ifndef MFILEDATASTORE_P_H
 #define MFILEDATASTORE_P_H
 
-#include <QSettings>
 #include <QScopedPointer>
-#include <QFileSystemWatcher>
+#include <QSettings>
 #include <QMap>
+#include <QTimer>
+#include <QDateTime>
+
+class MFileDataStore;
 
 class MFileDataStorePrivate
 {
 public:
-    MFileDataStorePrivate(const QString &filePath);
+    //! Identifies a version of the settings file without reading it
+    struct FileStamp
+    {
+        FileStamp() : exists(false), size(0) {}
+        static FileStamp of(const QString &filePath);
+        bool operator==(const FileStamp &other) const;
+        bool operator!=(const FileStamp &other) const { return !(*this == other); }
+
+        bool exists;
+        qint64 size;
+        QDateTime modified;
+    };
+
+    MFileDataStorePrivate(const QString &filePath, MFileDataStore *q);
+
+    //! Returns new settings for the file, written atomically
+    static QSettings *createSettings(const QString &filePath);
+
+    /*!
+     * Syncs the settings with the file and records the version written.
+     * \return false if writing failed.
+     */
+    bool sync();
+
+    /*!
+     * Replaces the settings after a failed sync, keeping the values which
+     * couldn't be written so that they are written by the next sync.
+     */
+    void resetSettings();
+
+    //! Records the version of the file as it is now
+    void updateFileStamp();
+
+    //! Reads all settings into a map sorted by key
+    QMap<QString, QVariant> readValues() const;
 
-    //! The used data storing backend
-    QSettings settings;
+    //! Returns whether changes are kept in memory instead of being written immediately.
+    bool isDeferred() const { return flushDelay >= 0 || batchDepth > 0; }
+
+    /*!
+     * Writes changed settings to the file, or marks them pending if writes are deferred.
+     * \return false if writing failed.
+     */
+    bool write();
+
+    MFileDataStore * const q_ptr;
+
+    //! The used data storing backend, replaced when writing fails
+    QScopedPointer<QSettings> settings;
 
     //! Snapshot of the settings, used for observing external file changes
     QMap<QString, QVariant> settingsSnapshot;
 
-    //! File system watcher wrapped with QScopedPointer to monitor changes in the settings file
-    QScopedPointer<QFileSystemWatcher> watcher;
+    //! The version of the file the snapshot corresponds to
+    FileStamp fileStamp;
+
+    //! Whether a sync has merged changes of another writer which haven't been signaled yet
+    bool externalChanges;
+
+    //! Delay of deferred writes in milliseconds, negative if changes are written immediately
+    int flushDelay;
+
+    //! Nesting depth of beginBatch() calls
+    int batchDepth;
+
+    //! Whether there are changes which haven't been written yet
+    bool dirty;
+
+    //! Writes pending changes once the flush delay has passed
+    QTimer flushTimer;
+
+    Q_DECLARE_PUBLIC(MFileDataStore)
 };
 
 #endif // MFILEDATASTORE_P_H
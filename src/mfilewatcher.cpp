@@ -0,0 +1,213 @@
+/***************************************************************************
+** Copyright (C) 2026 Jolla Ltd.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+#include <QSocketNotifier>
+#include <QThread>
+
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include "mfilewatcher_p.h"
+#include "logging.h"
+
+namespace {
+// Writes in place end with IN_CLOSE_WRITE, atomic writes with IN_MOVED_TO.
+const uint32_t DirectoryMask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE
+        | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+}
+
+Q_GLOBAL_STATIC(MFileWatcher, processWatcher)
+
+MFileWatcher::MFileWatcher()
+    : notifier(0)
+    , inotifyFd(inotify_init1(IN_NONBLOCK | IN_CLOEXEC))
+{
+    if (inotifyFd < 0) {
+        qCWarning(lcMlite) << "Could not create inotify instance:" << strerror(errno);
+        return;
+    }
+
+    notifier = new QSocketNotifier(inotifyFd, QSocketNotifier::Read, this);
+    connect(notifier, &QSocketNotifier::activated, this, &MFileWatcher::readEvents);
+
+    // Read the events in the main thread whichever thread happens to create the watcher.
+    QCoreApplication *application = QCoreApplication::instance();
+    if (application && application->thread() != thread())
+        moveToThread(application->thread());
+}
+
+MFileWatcher::~MFileWatcher()
+{
+    delete notifier;
+    if (inotifyFd >= 0)
+        close(inotifyFd);
+}
+
+MFileWatcher *MFileWatcher::instance()
+{
+    return processWatcher();
+}
+
+QString MFileWatcher::directoryPath(const QString &filePath)
+{
+    const QString directory = QFileInfo(filePath).absolutePath();
+    const QString canonical = QFileInfo(directory).canonicalFilePath();
+    return canonical.isEmpty() ? directory : canonical;
+}
+
+void MFileWatcher::addFile(const QString &filePath, QObject *client)
+{
+    const QString path = directoryPath(filePath);
+    const QString name = QFileInfo(filePath).fileName();
+
+    QMutexLocker locker(&mutex);
+    Directory &directory = directories[path];
+
+    ClientList &clients = directory.clients[name];
+    bool found = false;
+    for (const Client &existing : clients)
+        found = found || (existing.object == client && existing.filePath == filePath);
+    if (!found) {
+        Client entry;
+        entry.filePath = filePath;
+        entry.object = client;
+        clients.append(entry);
+    }
+
+    if (directory.watch >= 0 || inotifyFd < 0)
+        return;
+
+    const int watch = inotify_add_watch(inotifyFd, QFile::encodeName(path).constData(), DirectoryMask);
+    if (watch < 0) {
+        // The directory may be created later, the client adds the file again then.
+        if (errno != ENOENT)
+            qCWarning(lcMlite) << "Could not watch directory" << path << strerror(errno);
+        return;
+    }
+    directory.watch = watch;
+    watches.insert(watch, path);
+}
+
+void MFileWatcher::removeFile(const QString &filePath, QObject *client)
+{
+    const QString name = QFileInfo(filePath).fileName();
+
+    // Looked up in every directory, the canonical path of the directory may have changed
+    // since the file was added.
+    QMutexLocker locker(&mutex);
+    for (QHash<QString, Directory>::iterator directory = directories.begin(); directory != directories.end();) {
+        QHash<QString, ClientList>::iterator clients = directory->clients.find(name);
+        if (clients != directory->clients.end()) {
+            for (ClientList::iterator it = clients->begin(); it != clients->end();) {
+                if (it->object == client && it->filePath == filePath)
+                    it = clients->erase(it);
+                else
+                    ++it;
+            }
+            if (clients->isEmpty())
+                directory->clients.erase(clients);
+        }
+
+        if (directory->clients.isEmpty()) {
+            if (directory->watch >= 0) {
+                inotify_rm_watch(inotifyFd, directory->watch);
+                watches.remove(directory->watch);
+            }
+            directory = directories.erase(directory);
+        } else {
+            ++directory;
+        }
+    }
+}
+
+void MFileWatcher::notifyClients(const QString &directory, const QString &name) const
+{
+    QHash<QString, Directory>::const_iterator it = directories.constFind(directory);
+    if (it == directories.constEnd())
+        return;
+
+    // Queued while the clients can't be removed, the call is dropped if the client is destroyed
+    // before it's delivered. Clients add and remove files when notified, which locks the mutex.
+    for (QHash<QString, ClientList>::const_iterator file = it->clients.constBegin();
+            file != it->clients.constEnd(); ++file) {
+        if (!name.isEmpty() && file.key() != name)
+            continue;
+        for (const Client &client : file.value()) {
+            QMetaObject::invokeMethod(client.object, "fileChanged", Qt::QueuedConnection,
+                                      Q_ARG(QString, client.filePath));
+        }
+    }
+}
+
+void MFileWatcher::readEvents()
+{
+    // Large enough for several events with a name of NAME_MAX bytes.
+    alignas(inotify_event) char buffer[4 * (sizeof(inotify_event) + NAME_MAX + 1)];
+
+    QSet<QString> changed;
+
+    QMutexLocker locker(&mutex);
+    for (;;) {
+        const ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+        if (length <= 0)
+            break;
+
+        for (const char *p = buffer; p < buffer + length;) {
+            const inotify_event *event = reinterpret_cast<const inotify_event *>(p);
+            p += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                qCDebug(lcMlite) << "File watcher queue overflow, notifying all files";
+                for (QHash<QString, Directory>::const_iterator it = directories.constBegin();
+                        it != directories.constEnd(); ++it) {
+                    if (!changed.contains(it.key())) {
+                        changed.insert(it.key());
+                        notifyClients(it.key(), QString());
+                    }
+                }
+                continue;
+            }
+
+            const QString directory = watches.value(event->wd);
+            if (directory.isEmpty())
+                continue;
+
+            if (event->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF)) {
+                // The directory is gone, so are its files.
+                if (!(event->mask & IN_IGNORED))
+                    inotify_rm_watch(inotifyFd, event->wd);
+                watches.remove(event->wd);
+                directories[directory].watch = -1;
+                if (!changed.contains(directory)) {
+                    changed.insert(directory);
+                    notifyClients(directory, QString());
+                }
+                continue;
+            }
+
+            if (event->len > 0) {
+                const QString name = QFile::decodeName(event->name);
+                const QString filePath = directory + QLatin1Char('/') + name;
+                if (!changed.contains(directory) && !changed.contains(filePath)) {
+                    changed.insert(filePath);
+                    notifyClients(directory, name);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,86 @@
+/***************************************************************************
+** Copyright (C) 2026 Jolla Ltd.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef MFILEWATCHER_P_H
+#define MFILEWATCHER_P_H
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+class QSocketNotifier;
+
+/*!
+ * Watches files for the whole process through one inotify instance. Only the
+ * directories of the files are watched, each once however many files in it
+ * are watched, and each change is delivered to the clients of the changed
+ * file only.
+ *
+ * Files may be added and removed from any thread. Clients are notified with
+ * a queued call in their own thread, posted while the client is registered,
+ * so a client must remove its files before it is destroyed.
+ */
+class MFileWatcher : public QObject
+{
+public:
+    MFileWatcher();
+    ~MFileWatcher();
+
+    //! Returns the watcher of the process, null during process exit.
+    static MFileWatcher *instance();
+
+    /*!
+     * Calls the fileChanged(QString) slot of \a client with \a filePath when
+     * the file is written, replaced or removed, until removeFile is called.
+     * Adding a file again retries watching its directory if it didn't exist
+     * before.
+     */
+    void addFile(const QString &filePath, QObject *client);
+
+    //! Stops notifying \a client of changes to \a filePath.
+    void removeFile(const QString &filePath, QObject *client);
+
+private:
+    struct Client
+    {
+        QString filePath;
+        QObject *object;
+    };
+    typedef QVector<Client> ClientList;
+
+    struct Directory
+    {
+        Directory() : watch(-1) {}
+
+        //! The inotify watch descriptor, -1 while the directory isn't watched.
+        int watch;
+        //! The clients by file name.
+        QHash<QString, ClientList> clients;
+    };
+
+    static QString directoryPath(const QString &filePath);
+    void readEvents();
+    //! Notifies the clients of a file, or of all files in the directory if \a name is empty.
+    //! Call with the mutex locked.
+    void notifyClients(const QString &directory, const QString &name) const;
+
+    mutable QMutex mutex;
+    //! Directories by canonical path.
+    QHash<QString, Directory> directories;
+    //! Watched directories by inotify watch descriptor.
+    QHash<int, QString> watches;
+    QSocketNotifier *notifier;
+    int inotifyFd;
+};
+
+#endif /* MFILEWATCHER_P_H */
@@ -37,28 +37,26 @@ struct MGConfItemPrivate : public QObject
 
     void customEvent(QEvent* event);
     static QByteArray convertKey(const QString &key);
-    static void changed(DConfClient *, gchar *, GStrv, gchar *, gpointer);
 
     QString key;
     QVariant value;
     DConfClient *client;
-    gulong handler;
     QByteArray dconf_key;
 };
 
 MGConfItemPrivate::MGConfItemPrivate(QString aKey, MGConfItem* aParent)
     : QObject(aParent)
     , key(aKey)
-    , client(dconf_client_new())
-    , handler(g_signal_connect(client, "changed", G_CALLBACK(changed), this))
+    , client(MDConf::client())
     , dconf_key(convertKey(aKey))
 {
+    MDConf::subscribe(client, dconf_key, this);
     dconf_client_watch_fast(client, dconf_key);
 }
 
 MGConfItemPrivate::~MGConfItemPrivate()
 {
-    g_signal_handler_disconnect(client, handler);
+    MDConf::unsubscribe(client, dconf_key, this);
     dconf_client_unwatch_fast(client, dconf_key);
     g_object_unref(client);
 }
@@ -76,12 +74,6 @@ QByteArray MGConfItemPrivate::convertKey(const QString &key)
     }
 }
 
-void MGConfItemPrivate::changed(DConfClient*, gchar *prefix, GStrv changes, gchar*, gpointer data)
-{
-    MDConf::Event event(prefix, changes);
-    QCoreApplication::sendEvent((MGConfItemPrivate*)data, &event);
-}
-
 void MGConfItemPrivate::customEvent(QEvent* event)
 {
     if (event->type() == (QEvent::Type)MDConf::Event::TYPE) {
@@ -137,6 +129,7 @@ void MGConfItem::set(const QVariant &val)
 
     if (MDConf::convertValue(val, &v)) {
         GError *error = NULL;
+        MDConf::LocalWrite localWrite(priv->client, priv);
         dconf_client_write_fast(priv->client, priv->dconf_key, v, &error);
 
         if (error) {
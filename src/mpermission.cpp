@@ -11,199 +11,200 @@
 
 #include <QDebug>
 #include <QFile>
-#include <QLocale>
-#include <QTextStream>
 #include <QTranslator>
 
+#include <cstring>
+
 #include "mdesktopentry.h"
 #include "mpermission.h"
 #include "mpermission_p.h"
+#include "mpermissioncatalog.h"
+#include "mtranslations_p.h"
 #include "logging.h"
 
 namespace {
-const auto PermissionFileDirectory = QStringLiteral("/etc/sailjail/permissions/");
-const auto PermissionSuffix = QStringLiteral(".permission");
-const auto Prefix = QStringLiteral("x-sailjail-");
-const auto Description = QStringLiteral("description");
-const auto DescriptionTranslationKey = QStringLiteral("translation-key-description");
-const auto LongDescription = QStringLiteral("long-description");
-const auto LongDescriptionTranslationKey = QStringLiteral("translation-key-long-description");
-const auto TranslationCatalog = QStringLiteral("translation-catalog");
-const auto TranslationDirectory = QStringLiteral("/usr/share/translations");
-const auto TranslationSeparator = QStringLiteral("-");
-const auto SailjailSection = QStringLiteral("X-Sailjail");
-const auto SailjailPermissionsKey = QStringLiteral("Permissions");
-
-#if (QT_VERSION < QT_VERSION_CHECK(5, 14, 0))
-QPair<QStringRef, QStringRef> getField(const QString &line)
+const char FieldPrefix[] = "x-sailjail-";
+
+struct Fields
+{
+    QString description;
+    QString longDescription;
+    QString descriptionTranslationKey;
+    QString longDescriptionTranslationKey;
+    QString translationCatalog;
+};
+
+const struct {
+    const char *name;
+    QString Fields::*field;
+} FieldNames[] = {
+    { "description", &Fields::description },
+    { "long-description", &Fields::longDescription },
+    { "translation-key-description", &Fields::descriptionTranslationKey },
+    { "translation-key-long-description", &Fields::longDescriptionTranslationKey },
+    { "translation-catalog", &Fields::translationCatalog }
+};
+
+inline bool isSpace(char c)
 {
-    QStringRef remaining = line.midRef(0).trimmed();
-    if (!remaining.startsWith('#'))
-        return QPair<QStringRef, QStringRef>();
-
-    remaining = remaining.mid(1).trimmed();
-    if (!remaining.startsWith(Prefix))
-        return QPair<QStringRef, QStringRef>();
-
-    remaining = remaining.mid(Prefix.length());
-    int separator = remaining.indexOf('=');
-    if (separator == -1)
-        return QPair<QStringRef, QStringRef>();
-
-    QStringRef key = remaining.left(separator).trimmed();
-    QStringRef value = remaining.mid(separator+1).trimmed();
-    return QPair<QStringRef, QStringRef>(key, value);
+    return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
 }
-#else
-QPair<QStringView, QStringView> getField(const QString &line)
+
+// An invalid permission without a file, left in moved-from permissions. Holds a reference of
+// its own, so it's never deleted.
+MPermissionPrivate *sharedNullPrivate()
 {
-    QStringView remaining = line.mid(0).trimmed();
-    if (!remaining.startsWith('#'))
-        return QPair<QStringView, QStringView>();
-
-    remaining = remaining.mid(1).trimmed();
-    if (!remaining.startsWith(Prefix))
-        return QPair<QStringView, QStringView>();
-
-    remaining = remaining.mid(Prefix.length());
-    int separator = remaining.indexOf('=');
-    if (separator == -1)
-        return QPair<QStringView, QStringView>();
-
-    QStringView key = remaining.left(separator).trimmed();
-    QStringView value = remaining.mid(separator+1).trimmed();
-    return QPair<QStringView, QStringView>(key, value);
+    static MPermissionPrivate *const null = [] {
+        MPermissionPrivate *d = new MPermissionPrivate;
+        d->ref.ref();
+        return d;
+    }();
+    return null;
 }
-#endif
-} // namespace
 
-QHash<QString, QTranslator *> MPermissionPrivate::s_translators;
+inline void trim(const char **begin, const char **end)
+{
+    while (*begin < *end && isSpace(**begin))
+        ++*begin;
+    while (*end > *begin && isSpace((*end)[-1]))
+        --*end;
+}
 
-MPermissionPrivate::MPermissionPrivate(const QString &fileName) :
-    fileName(fileName)
+// Reads the "# x-sailjail-<field> = <value>" lines of the comment block a permission file starts
+// with, without decoding anything else. Stops at the first other line or when all fields are found.
+void scanHeader(const char *data, qint64 size, Fields *fields)
 {
+    const int prefixLength = sizeof(FieldPrefix) - 1;
+    const int fieldCount = sizeof(FieldNames) / sizeof(FieldNames[0]);
+    int found = 0;
+
+    const char *const end = data + size;
+    for (const char *line = data; line < end && found != (1 << fieldCount) - 1;) {
+        const char *lineEnd = static_cast<const char *>(memchr(line, '\n', end - line));
+        if (!lineEnd)
+            lineEnd = end;
+
+        const char *p = line;
+        const char *q = lineEnd;
+        line = lineEnd + 1;
+
+        trim(&p, &q);
+        if (p == q)
+            continue;
+        if (*p != '#')
+            break;
+
+        ++p;
+        trim(&p, &q);
+        if (q - p <= prefixLength || memcmp(p, FieldPrefix, prefixLength) != 0)
+            continue;
+        p += prefixLength;
+
+        const char *separator = static_cast<const char *>(memchr(p, '=', q - p));
+        if (!separator)
+            continue;
+
+        const char *keyEnd = separator;
+        trim(&p, &keyEnd);
+        const char *value = separator + 1;
+        trim(&value, &q);
+
+        for (int i = 0; i < fieldCount; ++i) {
+            if (qstrlen(FieldNames[i].name) == uint(keyEnd - p) && memcmp(FieldNames[i].name, p, keyEnd - p) == 0) {
+                fields->*FieldNames[i].field = QString::fromUtf8(value, int(q - value));
+                found |= 1 << i;
+                break;
+            }
+        }
+    }
+}
+} // namespace
+
+QExplicitlySharedDataPointer<MPermissionPrivate> MPermissionPrivate::read(const QString &fileName)
+{
+    QExplicitlySharedDataPointer<MPermissionPrivate> permission(new MPermissionPrivate);
+    permission->fileName = fileName;
+
     QFile file(fileName);
     if (!file.exists()) {
         qCWarning(lcMlite) << "Permission file" << file.fileName() << "does not exist!";
-        return;
+        return permission;
     }
 
     if (!file.open(QFile::ReadOnly)) {
         qCWarning(lcMlite) << "Permission file" << file.fileName() << "could not be opened!";
-        return;
+        return permission;
     }
 
-    QTextStream stream(&file);
-    QString description;
-    QString descriptionLong;
-    QString key;
-    QString keyLong;
-    QString catalog;
-    auto missing = [&] {
-        return description.isEmpty() || key.isEmpty()
-                || descriptionLong.isEmpty() || keyLong.isEmpty()
-                || catalog.isEmpty();
-    };
-    while (!stream.atEnd() && missing()) {
-        QString line = stream.readLine();
-#if (QT_VERSION < QT_VERSION_CHECK(5, 14, 0))
-        QPair<QStringRef, QStringRef> field = getField(line);
-#else
-        QPair<QStringView, QStringView> field = getField(line);
-#endif
-        if (field.first.isEmpty()) {
-            continue;
-        } else if (field.first == Description) {
-            description = field.second.toString();
-        } else if (field.first == LongDescription) {
-            descriptionLong = field.second.toString();
-        } else if (field.first == DescriptionTranslationKey) {
-            key = field.second.toString();
-        } else if (field.first == LongDescriptionTranslationKey) {
-            keyLong = field.second.toString();
-        } else if (field.first == TranslationCatalog) {
-            catalog = field.second.toString();
-        }
+    Fields fields;
+    const qint64 size = file.size();
+    if (uchar *mapped = size > 0 ? file.map(0, size) : 0) {
+        scanHeader(reinterpret_cast<const char *>(mapped), size, &fields);
+        file.unmap(mapped);
+    } else {
+        const QByteArray contents = file.readAll();
+        scanHeader(contents.constData(), contents.size(), &fields);
     }
 
-    if (description.isEmpty()) {
+    if (fields.description.isEmpty()) {
         qCWarning(lcMlite) << "Permission file" << file.fileName() << "is missing a required field.";
     } else {
-        fallbackDescription = std::move(description);
-        fallbackLongDescription = std::move(descriptionLong);
-        descriptionTranslationKey = std::move(key);
-        longDescriptionTranslationKey = std::move(keyLong);
-        translationCatalog = std::move(catalog);
+        permission->fallbackDescription = std::move(fields.description);
+        permission->fallbackLongDescription = std::move(fields.longDescription);
+        permission->descriptionTranslationKey = std::move(fields.descriptionTranslationKey);
+        permission->longDescriptionTranslationKey = std::move(fields.longDescriptionTranslationKey);
+        permission->translationCatalog = std::move(fields.translationCatalog);
     }
+
+    return permission;
 }
 
-MPermissionPrivate::MPermissionPrivate(const MPermissionPrivate &other) :
-    fileName(other.fileName),
-    fallbackDescription(other.fallbackDescription),
-    fallbackLongDescription(other.fallbackLongDescription),
-    translationCatalog(other.translationCatalog),
-    descriptionTranslationKey(other.descriptionTranslationKey),
-    longDescriptionTranslationKey(other.longDescriptionTranslationKey)
+MPermissionPrivate::~MPermissionPrivate()
 {
 }
 
-void MPermissionPrivate::replace(const MPermissionPrivate *other)
+QSharedPointer<const QTranslator> MPermissionPrivate::translator() const
 {
-    fileName = other->fileName;
-    fallbackDescription = other->fallbackDescription;
-    fallbackLongDescription = other->fallbackLongDescription;
-    translationCatalog = other->translationCatalog;
-    descriptionTranslationKey = other->descriptionTranslationKey;
-    longDescriptionTranslationKey = other->longDescriptionTranslationKey;
+    return MTranslations::translator(translationCatalog);
 }
 
-MPermissionPrivate::~MPermissionPrivate()
+MPermission::MPermission(const QString &fileName) :
+    d_ptr(0)
 {
+    const QExplicitlySharedDataPointer<MPermissionPrivate> data = MPermissionCatalog::instance()->data(fileName);
+    d_ptr = data.data();
+    d_ptr->ref.ref();
 }
 
-QTranslator *MPermissionPrivate::translator() const
+MPermission::MPermission(MPermissionPrivate *dd) :
+    d_ptr(dd)
 {
-    if (!s_translators.contains(translationCatalog)) {
-        QTranslator *translator = new QTranslator;
-        if (!translator->load(QLocale(), translationCatalog, TranslationSeparator, TranslationDirectory)) {
-            qCWarning(lcMlite) << "Failed to load translation catalog" << translationCatalog;
-            delete translator;
-            translator = 0; // Mark as failed
-        }
-        s_translators.insert(translationCatalog, translator);
-    }
-    return s_translators.value(translationCatalog);
+    d_ptr->ref.ref();
 }
 
-MPermission::MPermission(const QString &fileName) :
-    d_ptr(new MPermissionPrivate(fileName))
+MPermission::MPermission(const MPermission &other) :
+    d_ptr(other.d_ptr)
 {
+    if (d_ptr)
+        d_ptr->ref.ref();
 }
 
-MPermission::MPermission(const MPermission &other) :
-    d_ptr(new MPermissionPrivate(*other.d_ptr))
+MPermission::MPermission(MPermission &&other) noexcept :
+    d_ptr(sharedNullPrivate())
 {
+    d_ptr->ref.ref();
+    swap(other);
 }
 
 MPermission::~MPermission()
 {
-    delete d_ptr;
+    if (d_ptr && !d_ptr->ref.deref())
+        delete d_ptr;
 }
 
 QList<MPermission> MPermission::fromDesktopEntry(const MDesktopEntry &entry)
 {
-    QList<MPermission> permissions;
-    for (QString &name : entry.stringListValue(SailjailSection, SailjailPermissionsKey)) {
-        name = name.trimmed();
-        if (name.startsWith('!') || name.startsWith('?'))
-            name = name.remove(0, 1).trimmed();
-        if (!name.endsWith(PermissionSuffix))
-            name.append(PermissionSuffix);
-        MPermission permission(PermissionFileDirectory + name);
-        if (permission.isValid())
-            permissions.append(permission);
-    }
-    return permissions;
+    return MPermissionCatalog::instance()->fromDesktopEntry(entry);
 }
 
 QString MPermission::name() const
@@ -224,7 +225,7 @@ QString MPermission::description() const
         return d_ptr->fallbackDescription;
 
     QString description;
-    QTranslator *translator = d_ptr->translator();
+    const QSharedPointer<const QTranslator> translator = d_ptr->translator();
     if (translator)
         description = translator->translate(0, d_ptr->descriptionTranslationKey.toUtf8().constData(), 0, -1);
     return description.isEmpty() ? d_ptr->fallbackDescription : description;
@@ -241,7 +242,7 @@ QString MPermission::longDescription() const
         return d_ptr->fallbackLongDescription;
 
     QString description;
-    QTranslator *translator = d_ptr->translator();
+    const QSharedPointer<const QTranslator> translator = d_ptr->translator();
     if (translator)
         description = translator->translate(0, d_ptr->longDescriptionTranslationKey.toUtf8().constData(), 0, -1);
     return description.isEmpty() ? d_ptr->fallbackLongDescription : description;
@@ -254,10 +255,18 @@ QString MPermission::longDescriptionUnlocalized() const
 
 MPermission &MPermission::operator=(const MPermission &other)
 {
-    if (&other == this)
-        return *this;
-
-    d_ptr->replace(other.d_ptr);
+    MPermission copy(other);
+    swap(copy);
+    return *this;
+}
 
+MPermission &MPermission::operator=(MPermission &&other) noexcept
+{
+    swap(other);
     return *this;
 }
+
+void MPermission::swap(MPermission &other) noexcept
+{
+    qSwap(d_ptr, other.d_ptr);
+}
@@ -28,19 +28,26 @@ class MLITESHARED_EXPORT MPermission
 public:
     /*!
      * Reads permission file for the permission and constructs a new
-     * MPermission instance.
+     * MPermission instance. Files of the system permission directory are
+     * read through the shared MPermissionCatalog.
      *
      * \param file name of the permission file to read.
      */
     MPermission(const QString &fileName);
 
     /*!
-     * Copy constructor.
+     * Copy constructor. The permission data is implicitly shared, copying
+     * only takes a reference.
      *
      * \param instance to copy.
      */
     MPermission(const MPermission &other);
 
+    /*!
+     * Move constructor, \a other is left an invalid permission without a file.
+     */
+    MPermission(MPermission &&other) noexcept;
+
     /*!
      * Destroys MPermission instance.
      */
@@ -48,7 +55,8 @@ public:
 
     /*!
      * Constructs a list of MPermission instances from permissions named
-     * by MDesktopEntry.
+     * by MDesktopEntry. The permissions are looked up from the shared
+     * MPermissionCatalog of the system permission directory.
      *
      * \param MDesktopEntry to read permissions from.
      */
@@ -92,14 +100,26 @@ public:
     QString longDescriptionUnlocalized() const;
 
     MPermission &operator=(const MPermission &);
+    MPermission &operator=(MPermission &&other) noexcept;
+
+    /*!
+     * Swaps this permission with \a other.
+     */
+    void swap(MPermission &other) noexcept;
+
 protected:
     /*! \internal */
-    //! Pointer to the private class
-    MPermissionPrivate *const d_ptr;
+    //! Pointer to the shared private class
+    MPermissionPrivate *d_ptr;
     /*! \internal_end */
 
 private:
+    MPermission(MPermissionPrivate *dd);
+
     Q_DECLARE_PRIVATE(MPermission);
+    friend class MPermissionCatalog;
 };
 
+Q_DECLARE_SHARED(MPermission)
+
 #endif /* MPERMISSION_H_ */
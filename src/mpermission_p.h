@@ -12,21 +12,23 @@
 #ifndef MPERMISSION_P_H
 #define MPERMISSION_P_H
 
-#include <QHash>
+#include <QExplicitlySharedDataPointer>
+#include <QSharedData>
+#include <QSharedPointer>
 #include <QString>
 
 class QTranslator;
 
-class MPermissionPrivate
+//! The parsed contents of a permission file, shared by the MPermission instances for it.
+class MPermissionPrivate : public QSharedData
 {
 public:
-    MPermissionPrivate(const QString &fileName);
-    MPermissionPrivate(const MPermissionPrivate &other);
-    void replace(const MPermissionPrivate *other);
+    //! Reads the header fields of a permission file, the permission is invalid if that fails.
+    static QExplicitlySharedDataPointer<MPermissionPrivate> read(const QString &fileName);
 
     virtual ~MPermissionPrivate();
 
-    QTranslator *translator() const;
+    QSharedPointer<const QTranslator> translator() const;
 
     QString fileName;
     QString fallbackDescription;
@@ -34,8 +36,6 @@ public:
     QString translationCatalog;
     QString descriptionTranslationKey;
     QString longDescriptionTranslationKey;
-
-    static QHash<QString, QTranslator *> s_translators;
 };
 
 #endif /* MPERMISSION_P_H */
@@ -0,0 +1,202 @@
+/***************************************************************************
+** Copyright (C) 2026 Jolla Ltd.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#include <QDir>
+#include <QFileInfo>
+
+#include "mdesktopentry.h"
+#include "mpermission_p.h"
+#include "mpermissioncatalog.h"
+#include "mpermissioncatalog_p.h"
+#include "logging.h"
+
+namespace {
+const auto PermissionFileDirectory = QStringLiteral("/etc/sailjail/permissions");
+const auto PermissionSuffix = QStringLiteral(".permission");
+const auto SailjailSection = QStringLiteral("X-Sailjail");
+const auto SailjailPermissionsKey = QStringLiteral("Permissions");
+}
+
+Q_GLOBAL_STATIC_WITH_ARGS(MPermissionCatalog, systemCatalog, (PermissionFileDirectory))
+
+MPermissionCatalogPrivate::MPermissionCatalogPrivate(const QString &directory)
+    : directory(QDir::cleanPath(directory))
+    , loaded(false)
+{
+}
+
+void MPermissionCatalogPrivate::validate() const
+{
+    const QDateTime modified = QFileInfo(directory).lastModified();
+    if (loaded && modified == directoryModified)
+        return;
+
+    QHash<QString, File> previous;
+    previous.swap(files);
+
+    const QFileInfoList infos = QDir(directory).entryInfoList(
+                QStringList() << QLatin1Char('*') + PermissionSuffix, QDir::Files, QDir::NoSort);
+    for (const QFileInfo &info : infos) {
+        const QString fileName = info.fileName();
+        const QString name = fileName.left(fileName.size() - PermissionSuffix.size());
+
+        File file;
+        file.modified = info.lastModified();
+        file.size = info.size();
+
+        QHash<QString, File>::const_iterator it = previous.constFind(name);
+        if (it != previous.constEnd() && it->modified == file.modified && it->size == file.size)
+            file.record = it->record;
+        else
+            file.record = MPermissionPrivate::read(info.filePath());
+
+        files.insert(name, file);
+    }
+
+    directoryModified = modified;
+    loaded = true;
+}
+
+void MPermissionCatalogPrivate::refresh(const QString &name, File *file) const
+{
+    // Rewriting a file in place doesn't touch the directory, a removed file does.
+    const QFileInfo info(fileName(name));
+    if (info.exists() && (info.lastModified() != file->modified || info.size() != file->size)) {
+        file->modified = info.lastModified();
+        file->size = info.size();
+        file->record = MPermissionPrivate::read(info.filePath());
+    }
+}
+
+QExplicitlySharedDataPointer<MPermissionPrivate> MPermissionCatalogPrivate::find(const QString &name) const
+{
+    QHash<QString, File>::iterator it = files.find(name);
+    if (it == files.end())
+        return QExplicitlySharedDataPointer<MPermissionPrivate>();
+
+    refresh(name, &it.value());
+    return it->record;
+}
+
+QString MPermissionCatalogPrivate::fileName(const QString &name) const
+{
+    return directory + QLatin1Char('/') + name + PermissionSuffix;
+}
+
+MPermissionCatalog::MPermissionCatalog(const QString &directory)
+    : d_ptr(new MPermissionCatalogPrivate(directory))
+{
+}
+
+MPermissionCatalog::~MPermissionCatalog()
+{
+    delete d_ptr;
+}
+
+MPermissionCatalog *MPermissionCatalog::instance()
+{
+    return systemCatalog();
+}
+
+QString MPermissionCatalog::directory() const
+{
+    Q_D(const MPermissionCatalog);
+    return d->directory;
+}
+
+QStringList MPermissionCatalog::names() const
+{
+    Q_D(const MPermissionCatalog);
+
+    QMutexLocker locker(&d->mutex);
+    d->validate();
+
+    QStringList result;
+    for (QHash<QString, MPermissionCatalogPrivate::File>::iterator it = d->files.begin();
+            it != d->files.end(); ++it) {
+        d->refresh(it.key(), &it.value());
+        if (!it->record->fallbackDescription.isEmpty())
+            result.append(it.key());
+    }
+    result.sort();
+    return result;
+}
+
+MPermission MPermissionCatalog::permission(const QString &name) const
+{
+    Q_D(const MPermissionCatalog);
+
+    QMutexLocker locker(&d->mutex);
+    d->validate();
+
+    QExplicitlySharedDataPointer<MPermissionPrivate> record = d->find(name);
+    if (!record) {
+        QExplicitlySharedDataPointer<MPermissionPrivate> missing(new MPermissionPrivate);
+        missing->fileName = d->fileName(name);
+        record = missing;
+    }
+    return MPermission(record.data());
+}
+
+QList<MPermission> MPermissionCatalog::fromDesktopEntry(const MDesktopEntry &entry) const
+{
+    Q_D(const MPermissionCatalog);
+
+    QList<MPermission> permissions;
+    const QStringList names = entry.stringListValue(SailjailSection, SailjailPermissionsKey);
+    if (names.isEmpty())
+        return permissions;
+
+    QMutexLocker locker(&d->mutex);
+    d->validate();
+
+    for (QString name : names) {
+        name = name.trimmed();
+        if (name.startsWith('!') || name.startsWith('?'))
+            name = name.remove(0, 1).trimmed();
+        if (name.endsWith(PermissionSuffix))
+            name.chop(PermissionSuffix.size());
+
+        const QExplicitlySharedDataPointer<MPermissionPrivate> record = d->find(name);
+        if (!record)
+            qCWarning(lcMlite) << "Permission file" << d->fileName(name) << "does not exist!";
+        else if (!record->fallbackDescription.isEmpty())
+            permissions.append(MPermission(record.data()));
+    }
+    return permissions;
+}
+
+void MPermissionCatalog::reload()
+{
+    Q_D(MPermissionCatalog);
+
+    QMutexLocker locker(&d->mutex);
+    d->loaded = false;
+    d->files.clear();
+}
+
+QExplicitlySharedDataPointer<MPermissionPrivate> MPermissionCatalog::data(const QString &fileName) const
+{
+    Q_D(const MPermissionCatalog);
+
+    const QFileInfo info(fileName);
+    if (info.absolutePath() == d->directory && info.fileName().endsWith(PermissionSuffix)) {
+        QMutexLocker locker(&d->mutex);
+        d->validate();
+
+        const QString name = info.fileName().left(info.fileName().size() - PermissionSuffix.size());
+        const QExplicitlySharedDataPointer<MPermissionPrivate> record = d->find(name);
+        if (record && record->fileName == fileName)
+            return record;
+    }
+
+    return MPermissionPrivate::read(fileName);
+}
@@ -0,0 +1,94 @@
+/***************************************************************************
+** Copyright (C) 2026 Jolla Ltd.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef MPERMISSIONCATALOG_H_
+#define MPERMISSIONCATALOG_H_
+
+#include <mlite-global.h>
+#include <QExplicitlySharedDataPointer>
+#include <QList>
+#include <QStringList>
+
+#include "mpermission.h"
+
+class MDesktopEntry;
+class MPermissionCatalogPrivate;
+class MPermissionPrivate;
+
+/*!
+ * MPermissionCatalog is subject to change in future versions.
+ *
+ * MPermissionCatalog reads all permission files of a directory once and
+ * shares the parsed permissions between the MPermission instances created
+ * from it. The directory is read on first use and again whenever its
+ * modification time has changed, reusing the permissions of the files
+ * which have not changed. The files of the permissions returned are
+ * checked for a changed modification time or size, so files rewritten in
+ * place are picked up as well. Safe to use from any thread.
+ *
+ * \internal
+ */
+class MLITESHARED_EXPORT MPermissionCatalog
+{
+public:
+    /*!
+     * Constructs a catalog of the permission files in \a directory.
+     */
+    explicit MPermissionCatalog(const QString &directory);
+
+    /*!
+     * Destroys the MPermissionCatalog.
+     */
+    ~MPermissionCatalog();
+
+    /*!
+     * Returns the catalog of the system permission directory,
+     * /etc/sailjail/permissions.
+     */
+    static MPermissionCatalog *instance();
+
+    /*!
+     * Returns the directory the permissions are read from.
+     */
+    QString directory() const;
+
+    /*!
+     * Returns the names of the valid permissions in the directory, sorted.
+     */
+    QStringList names() const;
+
+    /*!
+     * Returns the permission called \a name, which is invalid if the
+     * directory doesn't have a valid permission file for it.
+     */
+    MPermission permission(const QString &name) const;
+
+    /*!
+     * Returns the valid permissions named by the X-Sailjail Permissions key
+     * of \a entry.
+     */
+    QList<MPermission> fromDesktopEntry(const MDesktopEntry &entry) const;
+
+    /*!
+     * Forgets the read permissions, all files are read again on next use.
+     */
+    void reload();
+
+private:
+    QExplicitlySharedDataPointer<MPermissionPrivate> data(const QString &fileName) const;
+
+    Q_DISABLE_COPY(MPermissionCatalog)
+    MPermissionCatalogPrivate *const d_ptr;
+    Q_DECLARE_PRIVATE(MPermissionCatalog)
+    friend class MPermission;
+};
+
+#endif /* MPERMISSIONCATALOG_H_ */
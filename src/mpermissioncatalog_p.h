@@ -0,0 +1,51 @@
+/***************************************************************************
+** Copyright (C) 2026 Jolla Ltd.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef MPERMISSIONCATALOG_P_H
+#define MPERMISSIONCATALOG_P_H
+
+#include <QDateTime>
+#include <QExplicitlySharedDataPointer>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+class MPermissionPrivate;
+
+class MPermissionCatalogPrivate
+{
+public:
+    struct File
+    {
+        QExplicitlySharedDataPointer<MPermissionPrivate> record;
+        QDateTime modified;
+        qint64 size;
+    };
+
+    MPermissionCatalogPrivate(const QString &directory);
+
+    //! Rereads the directory if it has changed, called with the mutex locked.
+    void validate() const;
+    //! Rereads a file which was rewritten in place, called with the mutex locked.
+    void refresh(const QString &name, File *file) const;
+    //! Returns the up to date permission of a name, called with the mutex locked.
+    QExplicitlySharedDataPointer<MPermissionPrivate> find(const QString &name) const;
+    QString fileName(const QString &name) const;
+
+    const QString directory;
+    mutable QMutex mutex;
+    mutable bool loaded;
+    mutable QDateTime directoryModified;
+    //! The permission files by permission name.
+    mutable QHash<QString, File> files;
+};
+
+#endif /* MPERMISSIONCATALOG_P_H */
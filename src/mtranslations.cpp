@@ -0,0 +1,185 @@
+/***************************************************************************
+** Copyright (C) 2026 Jolla Ltd.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#include <QAtomicInt>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QLocale>
+#include <QReadWriteLock>
+#include <QTranslator>
+
+#include "mtranslations_p.h"
+#include "logging.h"
+
+namespace {
+const QString TranslationDirectory = QStringLiteral("/usr/share/translations");
+const QString TranslationSeparator = QStringLiteral("-");
+const int MaximumTranslators = 16;
+// How long a catalog which failed to load is not tried again.
+const qint64 FailedCatalogTimeout = 60 * 1000;
+
+struct TranslatorCache
+{
+    struct Entry
+    {
+        QSharedPointer<const QTranslator> translator;
+        qint64 loaded;
+        // Use counter value of the last lookup, for evicting the least recently used.
+        mutable QAtomicInt lastUsed;
+    };
+
+    TranslatorCache() : generation(0) { clock.start(); }
+
+    // Call with lock locked for reading.
+    const Entry *find(const QString &catalog) const;
+    // Drops the translators of an older locale generation, call with lock locked for writing.
+    void setGeneration(int current);
+    void evict();
+
+    QReadWriteLock lock;
+    QElapsedTimer clock;
+    mutable QAtomicInt useCounter;
+    // The locale generation the translators were loaded for.
+    int generation;
+    QHash<QString, Entry> translators;
+};
+
+Q_GLOBAL_STATIC(TranslatorCache, translatorCache)
+
+// Changed whenever the locale changes, read on every localized lookup.
+QAtomicInt currentGeneration(0);
+// Hash of the locale environment and default locale the generation was last checked against.
+QAtomicInt currentFingerprint(0);
+
+const TranslatorCache::Entry *TranslatorCache::find(const QString &catalog) const
+{
+    QHash<QString, Entry>::const_iterator it = translators.constFind(catalog);
+    if (it == translators.constEnd())
+        return 0;
+    if (!it->translator && clock.elapsed() - it->loaded >= FailedCatalogTimeout)
+        return 0;
+
+    it->lastUsed.fetchAndStoreRelaxed(useCounter.fetchAndAddRelaxed(1));
+    return &it.value();
+}
+
+void TranslatorCache::setGeneration(int current)
+{
+    if (current != generation) {
+        translators.clear();
+        generation = current;
+    }
+}
+
+void TranslatorCache::evict()
+{
+    while (translators.count() > MaximumTranslators) {
+        QHash<QString, Entry>::iterator oldest = translators.begin();
+        for (QHash<QString, Entry>::iterator it = translators.begin(); it != translators.end(); ++it) {
+            // Compared as a difference, the counter may wrap around.
+            if (int(uint(it->lastUsed.loadAcquire()) - uint(oldest->lastUsed.loadAcquire())) < 0)
+                oldest = it;
+        }
+        translators.erase(oldest);
+    }
+}
+}
+
+QSharedPointer<const QTranslator> MTranslations::translator(const QString &catalog)
+{
+    if (catalog.isEmpty())
+        return QSharedPointer<const QTranslator>();
+
+    TranslatorCache *cache = translatorCache();
+    if (!cache)
+        return QSharedPointer<const QTranslator>();
+
+    const int generation = localeGeneration();
+
+    {
+        QReadLocker locker(&cache->lock);
+        if (generation == cache->generation) {
+            if (const TranslatorCache::Entry *entry = cache->find(catalog))
+                return entry->translator;
+        }
+    }
+
+    // Loaded unlocked, so lookups of other catalogs don't wait for the file to be read.
+    QSharedPointer<const QTranslator> translator;
+    QTranslator *loaded = new QTranslator;
+    if (loaded->load(QLocale(), catalog, TranslationSeparator, TranslationDirectory)) {
+        translator.reset(loaded);
+    } else {
+        qCDebug(lcMlite) << "Unable to load catalog" << catalog;
+        delete loaded;
+    }
+
+    QWriteLocker locker(&cache->lock);
+    // The locale changed while loading, the translator is usable once but not worth keeping.
+    if (generation != currentGeneration.loadAcquire())
+        return translator;
+
+    cache->setGeneration(generation);
+    // Another thread loaded the same catalog meanwhile, share its translator.
+    if (const TranslatorCache::Entry *entry = cache->find(catalog))
+        return entry->translator;
+
+    TranslatorCache::Entry &entry = cache->translators[catalog];
+    entry.translator = translator;
+    entry.loaded = cache->clock.elapsed();
+    entry.lastUsed.fetchAndStoreRelaxed(cache->useCounter.fetchAndAddRelaxed(1));
+    cache->evict();
+
+    return translator;
+}
+
+void MTranslations::clear()
+{
+    TranslatorCache *cache = translatorCache();
+    if (!cache)
+        return;
+
+    QWriteLocker locker(&cache->lock);
+    cache->translators.clear();
+}
+
+void MTranslations::invalidate()
+{
+    currentGeneration.fetchAndAddOrdered(1);
+}
+
+QByteArray MTranslations::localeEnvironment()
+{
+    const char *const variables[] = { "LANGUAGE", "LC_ALL", "LC_MESSAGES", "LANG" };
+    for (const char *variable : variables) {
+        const QByteArray locale = qgetenv(variable);
+        if (!locale.isEmpty())
+            return locale;
+    }
+    return QByteArray();
+}
+
+int MTranslations::localeGeneration()
+{
+    // The environment and the default locale can change without any notification, so they're
+    // compared on every call. Only the thread which records the new fingerprint bumps the
+    // generation.
+    const int fingerprint = int(qHash(localeEnvironment()) ^ qHash(QLocale().name()));
+    for (int previous = currentFingerprint.loadAcquire(); previous != fingerprint;
+            previous = currentFingerprint.loadAcquire()) {
+        if (currentFingerprint.testAndSetOrdered(previous, fingerprint)) {
+            currentGeneration.fetchAndAddOrdered(1);
+            break;
+        }
+    }
+    return currentGeneration.loadAcquire();
+}
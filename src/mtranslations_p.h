@@ -0,0 +1,48 @@
+/***************************************************************************
+** Copyright (C) 2026 Jolla Ltd.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef MTRANSLATIONS_P_H
+#define MTRANSLATIONS_P_H
+
+#include <QByteArray>
+#include <QSharedPointer>
+#include <QString>
+
+class QTranslator;
+
+namespace MTranslations
+{
+    // Returns the translator for a catalog in /usr/share/translations, or an absolute catalog
+    // path, in the default locale. Translators are shared by the whole process, the most recently
+    // used ones stay loaded, and they're reloaded after the locale has changed. A catalog
+    // which fails to load returns null without trying again for a minute.
+    // Safe to call from any thread, lookups of loaded catalogs run concurrently and catalogs
+    // are loaded without holding the cache lock.
+    QSharedPointer<const QTranslator> translator(const QString &catalog);
+
+    // Drops all cached translators, translators still referenced stay valid.
+    void clear();
+
+    // Marks translators and cached translations outdated. Changes of the default locale and
+    // the locale environment variables are noticed without it, this is for other changes like
+    // updated translation catalogs.
+    void invalidate();
+
+    // Returns a counter which changes whenever the default locale or the locale environment
+    // variables change or the locale is invalidated, for invalidating cached translations.
+    int localeGeneration();
+
+    // Returns the locale environment variable in effect, in the order of precedence
+    // g_get_language_names() uses.
+    QByteArray localeEnvironment();
+}
+
+#endif /* MTRANSLATIONS_P_H */
@@ -56,8 +56,16 @@ SOURCES += mnotificationmanagerproxy.cpp \
            mnotificationgroup.cpp \
            mremoteaction.cpp \
            mdesktopentry.cpp \
+           mdesktopentrycache.cpp \
+           mdesktopentrywatcher.cpp \
+           mdesktopentrysearchindex.cpp \
+           mdesktopentrytypeindex.cpp \
            mpermission.cpp \
+           mpermissioncatalog.cpp \
            mfiledatastore.cpp \
+           mbinarydatastore.cpp \
+           mfilewatcher.cpp \
+           mtranslations.cpp \
            logging.cpp
 
 HEADERS += mnotificationmanagerproxy.h \
@@ -70,9 +78,17 @@ HEADERS += mnotificationmanagerproxy.h \
            mremoteaction.h \
            mremoteaction_p.h \
            mdesktopentry_p.h \
+           mdesktopentrycache_p.h \
+           mdesktopentrywatcher_p.h \
+           mdesktopentrysearchindex_p.h \
+           mdesktopentrytypeindex_p.h \
            mpermission_p.h \
+           mpermissioncatalog_p.h \
            mlite-global.h \
            mfiledatastore_p.h \
+           mbinarydatastore_p.h \
+           mfilewatcher_p.h \
+           mtranslations_p.h \
            mdataaccess.h \
            mdatastore.h \
            logging.h
@@ -84,11 +100,22 @@ INSTALL_HEADERS += mnotification.h \
                    MNotificationGroup \
                    MRemoteAction \
                    mdesktopentry.h \
+                   mdesktopentrycache.h \
+                   mdesktopentrywatcher.h \
+                   mdesktopentrysearchindex.h \
+                   mdesktopentrytypeindex.h \
                    mpermission.h \
+                   mpermissioncatalog.h \
                    mlite-global.h \
                    mfiledatastore.h \
+                   mbinarydatastore.h \
                    MDesktopEntry \
-                   MPermission
+                   MDesktopEntryCache \
+                   MDesktopEntryWatcher \
+                   MDesktopEntrySearchIndex \
+                   MDesktopEntryTypeIndex \
+                   MPermission \
+                   MPermissionCatalog
 
 HEADERS *= $$INSTALL_HEADERS
 
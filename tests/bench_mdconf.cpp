@@ -0,0 +1,353 @@
+#include <dconf/dconf.h>
+
+#include <QTest>
+#include <QtTest/QSignalSpy>
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QPoint>
+#include <QRect>
+#include <QSize>
+#include <QStandardPaths>
+#include <QStringList>
+#include <QTemporaryDir>
+
+#include "mdconf_p.h"
+#include "mdconfitem.h"
+
+namespace Tests {
+
+class BenchMDConf : public QObject
+{
+    Q_OBJECT
+
+public:
+    BenchMDConf()
+        : m_client(0)
+    {
+    }
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void toGVariant_data() { conversionData(); }
+    void toGVariant();
+    void fromGVariant_data() { conversionData(); }
+    void fromGVariant();
+    void convertGeometry_data();
+    void convertGeometry();
+    void convertStringList_data();
+    void convertStringList();
+    void itemConstruction();
+    void itemRead();
+    void itemNotify();
+
+private:
+    void conversionData();
+
+    QTemporaryDir m_profileDir;
+    QString m_database;
+    DConfClient *m_client;
+};
+
+} // namespace Tests
+
+using namespace Tests;
+
+namespace {
+
+// The conversions as they were before values were read from the serialized data, for comparison.
+template <typename T> T legacyTupleValue(GVariant *tuple, int index)
+{
+    GVariant *child = g_variant_get_child_value(tuple, index);
+    QVariant value = MDConf::convertValue(child);
+    g_variant_unref(child);
+
+    return value.value<T>();
+}
+
+QVariant legacyConvertGeometry(GVariant *value, int typeHint)
+{
+    switch (typeHint) {
+    case QMetaType::QPoint:
+        return QPoint(legacyTupleValue<int>(value, 0), legacyTupleValue<int>(value, 1));
+    case QMetaType::QSizeF:
+        return QSizeF(legacyTupleValue<qreal>(value, 0), legacyTupleValue<qreal>(value, 1));
+    case QMetaType::QRect:
+        return QRect(
+                    legacyTupleValue<qreal>(value, 0),
+                    legacyTupleValue<qreal>(value, 1),
+                    legacyTupleValue<qreal>(value, 2),
+                    legacyTupleValue<qreal>(value, 3));
+    case QMetaType::QRectF:
+        return QRectF(
+                    legacyTupleValue<qreal>(value, 0),
+                    legacyTupleValue<qreal>(value, 1),
+                    legacyTupleValue<qreal>(value, 2),
+                    legacyTupleValue<qreal>(value, 3));
+    default:
+        return QVariant();
+    }
+}
+
+const QByteArray BenchPath("/mlite-tests/bench_mdconf/");
+
+QVariant legacyConvertStringList(GVariant *value)
+{
+    QStringList stringList;
+
+    gsize length = 0;
+    const gchar **strings = g_variant_get_strv(value, &length);
+    for (gsize i = 0; i < length ; ++i)
+        stringList.append(QString::fromUtf8(strings[i]));
+
+    g_free(strings);
+    return stringList;
+}
+
+GVariant *serialize(const QVariant &variant)
+{
+    GVariant *value = 0;
+    if (!MDConf::convertValue(variant, &value))
+        return 0;
+
+    // Serialize once up front, as values read from dconf are.
+    value = g_variant_ref_sink(value);
+    g_variant_get_data(value);
+    return value;
+}
+
+}
+
+void BenchMDConf::initTestCase()
+{
+    // Use a private user database so the benchmarks neither depend on nor disturb the
+    // user's settings.  The profile has to be in place before the first client is created.
+    QVERIFY(m_profileDir.isValid());
+    m_database = QStringLiteral("mlite-bench-%1").arg(QCoreApplication::applicationPid());
+    QFile profile(m_profileDir.filePath(QStringLiteral("profile")));
+    QVERIFY(profile.open(QIODevice::WriteOnly));
+    profile.write("user-db:" + QFile::encodeName(m_database) + "\n");
+    profile.close();
+    qputenv("DCONF_PROFILE", QFile::encodeName(profile.fileName()));
+
+    m_client = MDConf::client();
+}
+
+void BenchMDConf::cleanupTestCase()
+{
+    MDConf::clear(m_client, BenchPath, true);
+    MDConf::sync(m_client);
+    g_object_unref(m_client);
+
+    // The database is written by dconf-service, which doesn't share our environment, so it
+    // can't be redirected with XDG_CONFIG_HOME and is removed instead.
+    QFile::remove(QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation)
+                  + QStringLiteral("/dconf/") + m_database);
+}
+
+void BenchMDConf::conversionData()
+{
+    QTest::addColumn<QVariant>("variant");
+
+    QTest::newRow("bool") << QVariant(true);
+    QTest::newRow("char") << QVariant::fromValue(char(42));
+    QTest::newRow("qint16") << QVariant::fromValue(qint16(-4242));
+    QTest::newRow("quint16") << QVariant::fromValue(quint16(4242));
+    QTest::newRow("qint32") << QVariant::fromValue(qint32(-424242));
+    QTest::newRow("quint32") << QVariant::fromValue(quint32(424242));
+    QTest::newRow("qint64") << QVariant::fromValue(qint64(-4242424242LL));
+    QTest::newRow("quint64") << QVariant::fromValue(quint64(4242424242ULL));
+    QTest::newRow("double") << QVariant(42.42);
+    QTest::newRow("QPoint") << QVariant(QPoint(4, 6));
+    QTest::newRow("QPointF") << QVariant(QPointF(4.5, 6.5));
+    QTest::newRow("QSize") << QVariant(QSize(320, 240));
+    QTest::newRow("QSizeF") << QVariant(QSizeF(43.2, 42.3));
+    QTest::newRow("QRect") << QVariant(QRect(2, 3, 56, 67));
+    QTest::newRow("QRectF") << QVariant(QRectF(34.3, 342.1, 153.2, 12.22));
+
+    for (int size : { 1, 10, 100, 1000 }) {
+        const QByteArray tag = QByteArray::number(size);
+
+        QTest::newRow(("QString " + tag).constData()) << QVariant(QString(size, QLatin1Char('x')));
+        QTest::newRow(("QByteArray " + tag).constData()) << QVariant(QByteArray(size, 'x'));
+
+        QStringList stringList;
+        QList<QByteArray> byteArrayList;
+        QVariantList variantList;
+        QVariantMap variantMap;
+        for (int i = 0; i < size; ++i) {
+            const QString string = QStringLiteral("element %1").arg(i);
+            stringList.append(string);
+            byteArrayList.append(string.toUtf8());
+            variantList.append(i % 2 ? QVariant(string) : QVariant(i));
+            variantMap.insert(string, i % 2 ? QVariant(string) : QVariant(i));
+        }
+
+        QTest::newRow(("QStringList " + tag).constData()) << QVariant(stringList);
+        QTest::newRow(("QList<QByteArray> " + tag).constData()) << QVariant::fromValue(byteArrayList);
+        QTest::newRow(("QVariantList " + tag).constData()) << QVariant(variantList);
+        QTest::newRow(("QVariantMap " + tag).constData()) << QVariant(variantMap);
+    }
+}
+
+void BenchMDConf::toGVariant()
+{
+    QFETCH(QVariant, variant);
+
+    QBENCHMARK {
+        GVariant *value = 0;
+        MDConf::convertValue(variant, &value);
+        g_variant_unref(g_variant_ref_sink(value));
+    }
+}
+
+void BenchMDConf::fromGVariant()
+{
+    QFETCH(QVariant, variant);
+
+    GVariant * const value = serialize(variant);
+    QVERIFY(value);
+
+    const int typeHint = variant.userType();
+    QVariant result;
+    QBENCHMARK {
+        result = MDConf::convertValue(value, typeHint);
+    }
+
+    g_variant_unref(value);
+}
+
+void BenchMDConf::convertGeometry_data()
+{
+    QTest::addColumn<QVariant>("variant");
+    QTest::addColumn<bool>("legacy");
+
+    const QVariant values[] = {
+        QPoint(4, 6),
+        QSizeF(43.2, 42.3),
+        QRect(2, 3, 56, 67),
+        QRectF(34.3, 342.1, 153.2, 12.22)
+    };
+
+    for (const QVariant &value : values) {
+        QTest::newRow((QByteArray(value.typeName()) + " legacy").constData()) << value << true;
+        QTest::newRow((QByteArray(value.typeName()) + " serialized").constData()) << value << false;
+    }
+}
+
+void BenchMDConf::convertGeometry()
+{
+    QFETCH(QVariant, variant);
+    QFETCH(bool, legacy);
+
+    GVariant * const value = serialize(variant);
+    QVERIFY(value);
+
+    const int typeHint = variant.userType();
+    QCOMPARE(MDConf::convertValue(value, typeHint), variant);
+
+    QVariant result;
+    if (legacy) {
+        QBENCHMARK {
+            result = legacyConvertGeometry(value, typeHint);
+        }
+    } else {
+        QBENCHMARK {
+            result = MDConf::convertValue(value, typeHint);
+        }
+    }
+
+    g_variant_unref(value);
+}
+
+void BenchMDConf::convertStringList_data()
+{
+    QTest::addColumn<QVariant>("variant");
+    QTest::addColumn<bool>("legacy");
+
+    for (int count : { 1, 10, 100, 1000 }) {
+        QStringList list;
+        for (int i = 0; i < count; ++i)
+            list.append(QStringLiteral("string list element %1").arg(i));
+
+        QTest::newRow((QByteArray::number(count) + " legacy").constData()) << QVariant(list) << true;
+        QTest::newRow((QByteArray::number(count) + " serialized").constData()) << QVariant(list) << false;
+    }
+}
+
+void BenchMDConf::convertStringList()
+{
+    QFETCH(QVariant, variant);
+    QFETCH(bool, legacy);
+
+    GVariant * const value = serialize(variant);
+    QVERIFY(value);
+
+    QCOMPARE(MDConf::convertValue(value), variant);
+
+    QVariant result;
+    if (legacy) {
+        QBENCHMARK {
+            result = legacyConvertStringList(value);
+        }
+    } else {
+        QBENCHMARK {
+            result = MDConf::convertValue(value);
+        }
+    }
+
+    g_variant_unref(value);
+}
+
+void BenchMDConf::itemConstruction()
+{
+    const QString key = QString::fromUtf8(BenchPath + "construction");
+    MDConf::write(m_client, key.toUtf8(), QStringLiteral("value"), true);
+
+    // Keep one item alive so the shared client isn't recreated on every iteration.
+    MDConfItem item(key);
+    QBENCHMARK {
+        MDConfItem other(key);
+    }
+    QCOMPARE(item.value().toString(), QStringLiteral("value"));
+}
+
+void BenchMDConf::itemRead()
+{
+    const QByteArray key = BenchPath + "read";
+    MDConf::write(m_client, key, QStringList() << QStringLiteral("one") << QStringLiteral("two"), true);
+
+    QVariant value;
+    QBENCHMARK {
+        value = MDConf::read(m_client, key);
+    }
+    QCOMPARE(value.toStringList().count(), 2);
+}
+
+void BenchMDConf::itemNotify()
+{
+    const QByteArray key = BenchPath + "notify";
+
+    // Writes go through a client of their own, so the item is notified by dconf-service as for
+    // a write from another process rather than by the shared client directly.
+    DConfClient *writer = dconf_client_new();
+    MDConfItem reader(QString::fromUtf8(key));
+    QSignalSpy spy(&reader, SIGNAL(valueChanged()));
+
+    // Measures the time from a write until an item for the key has been notified.
+    int counter = 0;
+    QBENCHMARK {
+        MDConf::write(writer, key, ++counter);
+        while (spy.count() < counter)
+            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+    }
+    QCOMPARE(reader.value().toInt(), counter);
+
+    MDConf::sync(writer);
+    g_object_unref(writer);
+}
+
+QTEST_MAIN(Tests::BenchMDConf)
+
+#include "bench_mdconf.moc"
@@ -0,0 +1,4 @@
+include(testapplication.pri)
+
+CONFIG += link_pkgconfig
+PKGCONFIG += dconf
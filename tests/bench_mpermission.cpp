@@ -0,0 +1,179 @@
+#include <QTest>
+
+#include <QDir>
+#include <QFile>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include "mpermission.h"
+#include "mpermissioncatalog.h"
+
+namespace Tests {
+
+class BenchMPermission : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void readDirectory_data();
+    void readDirectory();
+    void fields();
+
+private:
+    QTemporaryDir m_generatedDir;
+};
+
+} // namespace Tests
+
+using namespace Tests;
+
+namespace {
+
+const QString SystemDirectory = QStringLiteral("/etc/sailjail/permissions");
+
+struct LegacyFields
+{
+    QString description;
+    QString longDescription;
+};
+
+// The permission file reader as it was before the header was scanned from the mapped file, for comparison.
+QPair<QString, QString> legacyField(const QString &line)
+{
+    QString remaining = line.trimmed();
+    if (!remaining.startsWith('#'))
+        return QPair<QString, QString>();
+
+    remaining = remaining.mid(1).trimmed();
+    if (!remaining.startsWith(QLatin1String("x-sailjail-")))
+        return QPair<QString, QString>();
+
+    remaining = remaining.mid(11);
+    const int separator = remaining.indexOf('=');
+    if (separator == -1)
+        return QPair<QString, QString>();
+
+    return qMakePair(remaining.left(separator).trimmed(), remaining.mid(separator + 1).trimmed());
+}
+
+LegacyFields legacyRead(const QString &fileName)
+{
+    LegacyFields fields;
+    QString key;
+    QString keyLong;
+    QString catalog;
+
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly))
+        return fields;
+
+    QTextStream stream(&file);
+    while (!stream.atEnd()
+           && (fields.description.isEmpty() || fields.longDescription.isEmpty()
+               || key.isEmpty() || keyLong.isEmpty() || catalog.isEmpty())) {
+        const QPair<QString, QString> field = legacyField(stream.readLine());
+        if (field.first == QLatin1String("description"))
+            fields.description = field.second;
+        else if (field.first == QLatin1String("long-description"))
+            fields.longDescription = field.second;
+        else if (field.first == QLatin1String("translation-key-description"))
+            key = field.second;
+        else if (field.first == QLatin1String("translation-key-long-description"))
+            keyLong = field.second;
+        else if (field.first == QLatin1String("translation-catalog"))
+            catalog = field.second;
+    }
+    return fields;
+}
+
+QStringList permissionFiles(const QString &directory)
+{
+    QStringList result;
+    for (const QString &fileName : QDir(directory).entryList(QStringList() << "*.permission", QDir::Files))
+        result.append(directory + QLatin1Char('/') + fileName);
+    return result;
+}
+
+}
+
+void BenchMPermission::initTestCase()
+{
+    // Permissions shaped like the ones of sailjail, a short header and a long firejail profile.
+    QVERIFY(m_generatedDir.isValid());
+    for (int i = 0; i < 50; ++i) {
+        QFile file(m_generatedDir.filePath(QStringLiteral("Permission%1.permission").arg(i)));
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        QTextStream out(&file);
+        out << "# -*- mode: sh -*-\n"
+            << "\n"
+            << "# x-sailjail-translation-catalog = sailjail-permissions\n"
+            << "# x-sailjail-translation-key-description = permission-la-data" << i << "\n"
+            << "# x-sailjail-description = Access data " << i << "\n"
+            << "# x-sailjail-translation-key-long-description = permission-la-data_description" << i << "\n"
+            << "# x-sailjail-long-description = Access the data " << i << " stored on the device\n"
+            << "\n";
+        for (int line = 0; line < 500; ++line)
+            out << "whitelist ${HOME}/.local/share/data" << i << "/directory" << line << "\n";
+    }
+}
+
+void BenchMPermission::readDirectory_data()
+{
+    QTest::addColumn<QString>("directory");
+    QTest::addColumn<bool>("legacy");
+
+    QTest::newRow("generated legacy") << m_generatedDir.path() << true;
+    QTest::newRow("generated scanned") << m_generatedDir.path() << false;
+
+    if (!permissionFiles(SystemDirectory).isEmpty()) {
+        QTest::newRow("system legacy") << SystemDirectory << true;
+        QTest::newRow("system scanned") << SystemDirectory << false;
+    }
+}
+
+void BenchMPermission::readDirectory()
+{
+    QFETCH(QString, directory);
+    QFETCH(bool, legacy);
+
+    const QStringList fileNames = permissionFiles(directory);
+    int valid = 0;
+
+    if (legacy) {
+        QBENCHMARK {
+            valid = 0;
+            for (const QString &fileName : fileNames) {
+                if (!legacyRead(fileName).description.isEmpty())
+                    ++valid;
+            }
+        }
+    } else {
+        MPermissionCatalog catalog(directory);
+        QBENCHMARK {
+            catalog.reload();
+            valid = catalog.names().count();
+        }
+    }
+
+    QVERIFY(valid > 0);
+}
+
+void BenchMPermission::fields()
+{
+    MPermissionCatalog catalog(m_generatedDir.path());
+
+    const QStringList fileNames = permissionFiles(m_generatedDir.path());
+    QCOMPARE(catalog.names().count(), fileNames.count());
+    for (const QString &fileName : fileNames) {
+        const LegacyFields expected = legacyRead(fileName);
+        const MPermission permission(fileName);
+        QCOMPARE(permission.descriptionUnlocalized(), expected.description);
+        QCOMPARE(permission.longDescriptionUnlocalized(), expected.longDescription);
+    }
+}
+
+QTEST_MAIN(Tests::BenchMPermission)
+
+#include "bench_mpermission.moc"
@@ -0,0 +1,44 @@
+#ifndef MLITE_TESTS_DESKTOPFILETESTUTILS_H
+#define MLITE_TESTS_DESKTOPFILETESTUTILS_H
+
+#include <QtCore/QFile>
+#include <QtCore/QList>
+#include <QtCore/QStringList>
+
+#include "mdesktopentry.h"
+
+namespace Tests {
+
+// Returns an application entry with the given keys appended to the required ones.
+inline QByteArray applicationEntry(const QByteArray &keys)
+{
+    return QByteArrayLiteral("[Desktop Entry]\nType=Application\n") + keys;
+}
+
+// Writes contents to directory/name and returns the full file name.
+inline QString writeDesktopFile(const QString &directory, const QString &name, const QByteArray &contents)
+{
+    const QString fileName = directory + QLatin1Char('/') + name;
+    QFile file(fileName);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        file.write(contents);
+    return fileName;
+}
+
+// Writes an application entry with the given keys to directory/name.desktop and reads it.
+inline MDesktopEntry createEntry(const QString &directory, const QString &name, const QByteArray &keys)
+{
+    return MDesktopEntry(writeDesktopFile(directory, name + QStringLiteral(".desktop"), applicationEntry(keys)));
+}
+
+inline QStringList entryNames(const QList<MDesktopEntry> &entries)
+{
+    QStringList result;
+    for (const MDesktopEntry &entry : entries)
+        result.append(entry.name());
+    return result;
+}
+
+} // namespace Tests
+
+#endif // MLITE_TESTS_DESKTOPFILETESTUTILS_H
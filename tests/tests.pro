@@ -3,13 +3,21 @@ include(tests_common.pri)
 TEMPLATE = subdirs
 SUBDIRS = \
         ut_mdesktopentry.pro \
+        ut_mdesktopentrycache.pro \
+        ut_mdesktopentrywatcher.pro \
+        ut_mdesktopentrysearchindex.pro \
+        ut_mdesktopentrytypeindex.pro \
         ut_mfiledatastore.pro \
+        ut_mbinarydatastore.pro \
+        ut_mpermissioncatalog.pro \
         ut_mnotification.pro \
         ut_mremoteaction.pro \
+        bench_mpermission.pro \
 
 packagesExist(dconf) {
     SUBDIRS += ut_mdconfgroup.pro
     SUBDIRS += ut_mdconfitem.pro
+    SUBDIRS += bench_mdconf.pro
 }
 
 configure($${PWD}/tests.xml.in)
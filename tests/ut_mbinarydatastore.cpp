@@ -0,0 +1,270 @@
+#include <QTest>
+#include <QtTest/QSignalSpy>
+#include <QtCore/QDir>
+#include <QtCore/QRunnable>
+#include <QtCore/QSaveFile>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QThreadPool>
+
+#include "mbinarydatastore.h"
+
+namespace Tests {
+
+class UtMBinaryDataStore : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void missingFile();
+    void valueTypes();
+    void setValue();
+    void removeAndClear();
+    void invalidFile();
+    void unsortedFile();
+    void otherInstanceChanges();
+    void writesReplaceFile();
+    void concurrentWriters();
+
+private:
+    QString filePath() const;
+
+    QScopedPointer<QTemporaryDir> m_dir;
+};
+
+class Writer : public QRunnable
+{
+public:
+    Writer(const QString &filePath, const QString &prefix)
+        : m_filePath(filePath), m_prefix(prefix)
+    {
+    }
+
+    void run()
+    {
+        MBinaryDataStore store(m_filePath);
+        for (int i = 0; i < 50; ++i)
+            store.createValue(m_prefix + QString::number(i), i);
+    }
+
+private:
+    const QString m_filePath;
+    const QString m_prefix;
+};
+
+} // namespace Tests
+
+using namespace Tests;
+
+void UtMBinaryDataStore::init()
+{
+    m_dir.reset(new QTemporaryDir);
+    QVERIFY(m_dir->isValid());
+}
+
+void UtMBinaryDataStore::cleanup()
+{
+    m_dir.reset();
+}
+
+QString UtMBinaryDataStore::filePath() const
+{
+    return m_dir->path() + QStringLiteral("/store.bin");
+}
+
+void UtMBinaryDataStore::missingFile()
+{
+    MBinaryDataStore store(filePath());
+
+    QVERIFY(store.isReadable());
+    QVERIFY(store.isWritable());
+    QVERIFY(store.allKeys().isEmpty());
+    QVERIFY(!store.contains("foo"));
+    QVERIFY(!store.value("foo").isValid());
+    QVERIFY(!QFile::exists(filePath()));
+}
+
+void UtMBinaryDataStore::valueTypes()
+{
+    QVariantMap values;
+    values.insert("bool", true);
+    values.insert("int", -42);
+    values.insert("uint", 42u);
+    values.insert("longlong", -(Q_INT64_C(1) << 40));
+    values.insert("ulonglong", Q_UINT64_C(1) << 63);
+    values.insert("double", 3.25);
+    values.insert("string", QString::fromUtf8("p\xc3\xa4iv\xc3\xa4\xc3\xa4"));
+    values.insert("empty", QString(""));
+    values.insert("bytes", QByteArray("\0\1\2", 3));
+    values.insert("list", QStringList() << "a" << "b");
+
+    {
+        MBinaryDataStore store(filePath());
+        for (QVariantMap::const_iterator it = values.constBegin(); it != values.constEnd(); ++it)
+            QVERIFY(store.createValue(it.key(), it.value()));
+    }
+
+    QFile file(filePath());
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(file.read(4), QByteArray("MLDS"));
+    file.close();
+
+    MBinaryDataStore store(filePath());
+    QCOMPARE(store.allKeys(), values.keys());
+    for (QVariantMap::const_iterator it = values.constBegin(); it != values.constEnd(); ++it) {
+        const QVariant value = store.value(it.key());
+        QCOMPARE(value.userType(), it.value().userType());
+        QCOMPARE(value, it.value());
+    }
+}
+
+void UtMBinaryDataStore::setValue()
+{
+    MBinaryDataStore store(filePath());
+    QSignalSpy spy(&store, SIGNAL(valueChanged(QString, QVariant)));
+
+    QVERIFY(!store.setValue("foo", "bar"));
+    QVERIFY(!store.contains("foo"));
+    QCOMPARE(spy.count(), 0);
+
+    QVERIFY(store.createValue("foo", "bar"));
+    QCOMPARE(spy.count(), 1);
+    QVERIFY(store.setValue("foo", "baz"));
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(spy.at(1).at(0).toString(), QString("foo"));
+    QCOMPARE(spy.at(1).at(1).toString(), QString("baz"));
+    QCOMPARE(store.value("foo").toString(), QString("baz"));
+
+    // Setting the same value again isn't a change
+    QVERIFY(store.setValue("foo", "baz"));
+    QCOMPARE(spy.count(), 2);
+}
+
+void UtMBinaryDataStore::removeAndClear()
+{
+    MBinaryDataStore store(filePath());
+    QVERIFY(store.createValue("a", 1));
+    QVERIFY(store.createValue("b", 2));
+    QVERIFY(store.createValue("c", 3));
+
+    QSignalSpy spy(&store, SIGNAL(valueChanged(QString, QVariant)));
+    store.remove("unknown");
+    QCOMPARE(spy.count(), 0);
+
+    store.remove("b");
+    QCOMPARE(spy.count(), 1);
+    QVERIFY(!spy.at(0).at(1).isValid());
+    QCOMPARE(store.allKeys(), QStringList() << "a" << "c");
+
+    store.clear();
+    QCOMPARE(spy.count(), 3);
+    QVERIFY(store.allKeys().isEmpty());
+    QVERIFY(MBinaryDataStore(filePath()).allKeys().isEmpty());
+}
+
+void UtMBinaryDataStore::invalidFile()
+{
+    QFile file(filePath());
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    QVERIFY(file.write("[General]\nfoo=bar\n") > 0);
+    file.close();
+
+    MBinaryDataStore store(filePath());
+    QVERIFY(!store.isReadable());
+    QVERIFY(!store.isWritable());
+    QVERIFY(store.allKeys().isEmpty());
+    QVERIFY(!store.createValue("foo", "baz"));
+
+    // The unknown file is left as it was
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(file.readAll(), QByteArray("[General]\nfoo=bar\n"));
+}
+
+void UtMBinaryDataStore::unsortedFile()
+{
+    MBinaryDataStore store(filePath());
+    QVERIFY(store.createValue("a", 1));
+    QVERIFY(store.createValue("b", 2));
+
+    // Replace the file with one where the key offsets and lengths of the two entries are swapped
+    QFile file(filePath());
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QByteArray content = file.readAll();
+    file.close();
+    const QByteArray first = content.mid(16, 8);
+    content.replace(16, 8, content.mid(36, 8));
+    content.replace(36, 8, first);
+    QSaveFile replacement(filePath());
+    QVERIFY(replacement.open(QIODevice::WriteOnly));
+    QCOMPARE(replacement.write(content), qint64(content.size()));
+    QVERIFY(replacement.commit());
+
+    QTRY_VERIFY(!store.isReadable());
+    QVERIFY(!store.isWritable());
+    QVERIFY(!store.createValue("c", 3));
+}
+
+void UtMBinaryDataStore::otherInstanceChanges()
+{
+    MBinaryDataStore store1(filePath());
+    MBinaryDataStore store2(filePath());
+    QSignalSpy spy1(&store1, SIGNAL(valueChanged(QString, QVariant)));
+    QSignalSpy spy2(&store2, SIGNAL(valueChanged(QString, QVariant)));
+
+    QVERIFY(store1.createValue("foo", "bar"));
+    QTRY_COMPARE(spy2.count(), 1);
+    QCOMPARE(spy2.at(0).at(0).toString(), QString("foo"));
+    QCOMPARE(spy2.at(0).at(1).toString(), QString("bar"));
+    QCOMPARE(store2.value("foo").toString(), QString("bar"));
+
+    // A change made by the other instance before noticing it is not lost
+    QVERIFY(store2.createValue("baz", 1));
+    QVERIFY(store1.createValue("qux", 2));
+    QCOMPARE(store1.allKeys(), QStringList() << "baz" << "foo" << "qux");
+
+    // The notifications of their own writes aren't signaled
+    QTest::qWait(100);
+    QCOMPARE(spy1.count(), 3);
+    QCOMPARE(store2.allKeys(), QStringList() << "baz" << "foo" << "qux");
+}
+
+void UtMBinaryDataStore::writesReplaceFile()
+{
+    MBinaryDataStore store(filePath());
+    QVERIFY(store.createValue("foo", "bar"));
+    QVERIFY(store.setValue("foo", "baz"));
+
+    QCOMPARE(QDir(m_dir->path()).entryList(QDir::Files), QStringList() << "store.bin");
+}
+
+void UtMBinaryDataStore::concurrentWriters()
+{
+    // Instances which haven't noticed each other's writes don't lose them.
+    MBinaryDataStore store1(filePath());
+    MBinaryDataStore store2(filePath());
+    QVERIFY(store1.createValue("a", 1));
+    QVERIFY(store2.createValue("b", 2));
+    QVERIFY(store1.createValue("c", 3));
+    QVERIFY(store2.setValue("a", 4));
+    QCOMPARE(MBinaryDataStore(filePath()).allKeys(), QStringList() << "a" << "b" << "c");
+    QCOMPARE(MBinaryDataStore(filePath()).value("a").toInt(), 4);
+
+    // Writers interleaving in several threads keep all keys.
+    QThreadPool pool;
+    pool.setMaxThreadCount(4);
+    const QStringList prefixes = QStringList() << "w" << "x" << "y" << "z";
+    for (const QString &prefix : prefixes)
+        pool.start(new Writer(filePath(), prefix));
+    QVERIFY(pool.waitForDone(60000));
+
+    MBinaryDataStore store(filePath());
+    QCOMPARE(store.allKeys().count(), 3 + 4 * 50);
+    for (const QString &prefix : prefixes)
+        QCOMPARE(store.value(prefix + "49").toInt(), 49);
+    QVERIFY(!QFile::exists(filePath() + ".lock"));
+}
+
+QTEST_MAIN(Tests::UtMBinaryDataStore)
+
+#include "ut_mbinarydatastore.moc"
@@ -43,6 +43,8 @@ private slots:
     void value();
     void scopes();
     void pathChangeInResolve();
+    void batch();
+    void lazyProperties();
 
 private:
     DConfClient *m_client;
@@ -208,6 +210,35 @@ void TestConfGroup::updatePath()
     setPath(parent->stringProperty());
 }
 
+class LazyConfGroup : public MDConfGroup
+{
+    Q_OBJECT
+    Q_PROPERTY(QString stringProperty READ stringProperty WRITE setStringProperty NOTIFY stringPropertyChanged)
+
+public:
+    LazyConfGroup(QObject *parent = 0)
+        : MDConfGroup(parent, BindPropertiesLazily)
+    {
+        resolveMetaObject(staticMetaObject.propertyOffset());
+    }
+
+    QString stringProperty() const
+    {
+        resolveProperty(staticMetaObject.indexOfProperty("stringProperty"));
+        return m_stringProperty;
+    }
+
+    void setStringProperty(QString stringProperty) { m_stringProperty = stringProperty; emit stringPropertyChanged(); }
+
+    QString storedStringProperty() const { return m_stringProperty; }
+
+signals:
+    void stringPropertyChanged();
+
+private:
+    QString m_stringProperty;
+};
+
 }
 
 using namespace Tests;
@@ -542,6 +573,60 @@ void UtMDConfGroup::pathChangeInResolve()
     QCOMPARE(nestedScope.stringProperty(), QStringLiteral("nested-value"));
 }
 
+void UtMDConfGroup::batch()
+{
+    MDConfGroup group1(QStringLiteral("/mlite-tests/ut_mdconfgroup/scopes/scope1/batch"));
+    MDConfGroup group2(QStringLiteral("/mlite-tests/ut_mdconfgroup/scopes/scope1/batch"));
+
+    QSignalSpy valueSpy(&group2, SIGNAL(valueChanged(QString)));
+
+    group1.beginBatch();
+    group1.setValue(QStringLiteral("first"), 1);
+    group1.beginBatch();
+    group1.setValue(QStringLiteral("second"), QStringLiteral("two"));
+    group1.commit();
+
+    QCOMPARE(group1.value(QStringLiteral("first")), QVariant(1));
+    QCOMPARE(group1.value(QStringLiteral("second")), QVariant(QStringLiteral("two")));
+    QCOMPARE(group2.value(QStringLiteral("first")), QVariant());
+
+    QTest::qWait(100);
+    QCOMPARE(valueSpy.count(), 0);
+
+    group1.commit();
+
+    QTRY_COMPARE(valueSpy.count(), 2);
+    QCOMPARE(group2.value(QStringLiteral("first")), QVariant(1));
+    QCOMPARE(group2.value(QStringLiteral("second")), QVariant(QStringLiteral("two")));
+
+    group1.beginBatch();
+    group1.clear();
+    QCOMPARE(group1.value(QStringLiteral("first"), QStringLiteral("default")), QVariant(QStringLiteral("default")));
+    group1.commit();
+
+    QTRY_COMPARE(group2.value(QStringLiteral("first")), QVariant());
+}
+
+void UtMDConfGroup::lazyProperties()
+{
+    MDConfGroup writer(QStringLiteral("/mlite-tests/ut_mdconfgroup/scopes/scope1/lazy"));
+    writer.setSynchronous(true);
+    writer.setValue(QStringLiteral("stringProperty"), QStringLiteral("stored"));
+
+    LazyConfGroup group;
+    group.setPath(QStringLiteral("/mlite-tests/ut_mdconfgroup/scopes/scope1/lazy"));
+
+    QCOMPARE(group.storedStringProperty(), QString());
+    QCOMPARE(group.stringProperty(), QStringLiteral("stored"));
+    QCOMPARE(group.storedStringProperty(), QStringLiteral("stored"));
+
+    QSignalSpy propertySpy(&group, SIGNAL(stringPropertyChanged()));
+    writer.setValue(QStringLiteral("stringProperty"), QStringLiteral("changed"));
+
+    QTRY_COMPARE(propertySpy.count(), 1);
+    QCOMPARE(group.storedStringProperty(), QStringLiteral("changed"));
+}
+
 QTEST_MAIN(Tests::UtMDConfGroup)
 
 #include "ut_mdconfgroup.moc"
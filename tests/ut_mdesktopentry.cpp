@@ -1,5 +1,7 @@
 #include <QTest>
+#include <QtCore/QBuffer>
 #include <QtCore/QDir>
+#include <QtCore/QTemporaryDir>
 #include <QtCore/QTemporaryFile>
 #include <QtCore/QTextStream>
 #include <QtCore/QTranslator>
@@ -45,8 +47,14 @@ private slots:
     void values();
     void localization_data();
     void localization();
+    void localeChange();
     void readForeignSection();
     void readDesktopFileToMap();
+    void readDesktopFileVisitor();
+    void escapes();
+    void whitespace();
+    void loadAll();
+    void implicitSharing();
 
 private:
     QString createDesktopEntry(const Values &values);
@@ -56,6 +64,49 @@ private:
     QTemporaryFile *m_temporaryFile;
 };
 
+// A sequential device which receives one chunk each time it is waited on, and then either ends
+// or fails.
+class ChunkedDevice : public QIODevice
+{
+public:
+    ChunkedDevice(const QList<QByteArray> &chunks, bool fail)
+        : m_chunks(chunks)
+        , m_fail(fail)
+    {
+        open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+    }
+
+    bool isSequential() const { return true; }
+    qint64 bytesAvailable() const { return m_available.size() + QIODevice::bytesAvailable(); }
+
+    bool waitForReadyRead(int)
+    {
+        if (m_chunks.isEmpty())
+            return false;
+        m_available += m_chunks.takeFirst();
+        return true;
+    }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize)
+    {
+        if (m_available.isEmpty())
+            return m_fail && m_chunks.isEmpty() ? -1 : 0;
+
+        const int size = int(qMin<qint64>(maxSize, m_available.size()));
+        memcpy(data, m_available.constData(), size);
+        m_available.remove(0, size);
+        return size;
+    }
+
+    qint64 writeData(const char *, qint64) { return -1; }
+
+private:
+    QList<QByteArray> m_chunks;
+    QByteArray m_available;
+    bool m_fail;
+};
+
 } // namespace Tests
 
 using namespace Tests;
@@ -423,6 +474,38 @@ void UtMDesktopEntry::localization()
     QVERIFY2(qtTrId("LogicalBar") != "LogicalBarTranslated", "MDesktopEntry: A translator was installed globally");
 }
 
+void UtMDesktopEntry::localeChange()
+{
+    unsetenv("LANGUAGE");
+    unsetenv("LC_ALL");
+    unsetenv("LC_MESSAGES");
+    qputenv("LANG", "en_US");
+
+    Values values;
+    values["Type"] = "Application";
+    values["Name"] = "Foo";
+    values["Comment"] = "Bar";
+    values["Exec"] = "true";
+    values["__tail__"] = "Name[fi]=FiFoo\nComment[fi]=FiBar";
+
+    MDesktopEntry entry(createDesktopEntry(values));
+    QCOMPARE(entry.name(), QString("Foo"));
+    QCOMPARE(entry.localizedValue("Comment"), QString("Bar"));
+
+    // Changes of the locale environment are followed without further notice
+    qputenv("LANG", "fi_FI");
+    QCOMPARE(entry.name(), QString("FiFoo"));
+    QCOMPARE(entry.localizedValue("Comment"), QString("FiBar"));
+
+    qputenv("LANGUAGE", "en_US");
+    QCOMPARE(entry.name(), QString("Foo"));
+    unsetenv("LANGUAGE");
+    QCOMPARE(entry.name(), QString("FiFoo"));
+
+    qputenv("LANG", "en_US");
+    QCOMPARE(entry.name(), QString("Foo"));
+}
+
 void UtMDesktopEntry::readForeignSection()
 {
     Values values;
@@ -463,6 +546,164 @@ void UtMDesktopEntry::readDesktopFileToMap()
     QCOMPARE(desktopEntriesMap["Desktop Entry/Categories"], QString("a;b;c"));
 }
 
+void UtMDesktopEntry::readDesktopFileVisitor()
+{
+    // A value longer than the read chunks and a last line without newline.
+    const QByteArray longValue(10000, 'x');
+    QByteArray contents = "# Comment\r\n[Desktop Entry]\r\nType=Application\r\nName[fi]=Nimi\\s\n";
+    contents += "Comment=" + longValue + "\n\n[Bar]\na=b\na=c";
+
+    QBuffer buffer(&contents);
+    buffer.open(QIODevice::ReadOnly);
+
+    QStringList visited;
+    QString comment;
+    const auto visitor = [&visited, &comment](const QString &group, const QString &key, const QString &value) {
+        if (key == QLatin1String("Comment"))
+            comment = value;
+        else
+            visited << group + QLatin1Char('/') + key + QLatin1Char('=') + value;
+    };
+
+    QVERIFY(MDesktopEntry::readDesktopFile(buffer, visitor));
+    QCOMPARE(visited, QStringList()
+             << "Desktop Entry/Type=Application"
+             << "Desktop Entry/Name[fi]=Nimi "
+             << "Bar/a=b"
+             << "Bar/a=c");
+    QCOMPARE(comment, QString::fromLatin1(longValue));
+
+    QByteArray foreign = "[Bar]\na=b\n";
+    QBuffer foreignBuffer(&foreign);
+    foreignBuffer.open(QIODevice::ReadOnly);
+    visited.clear();
+    QVERIFY(!MDesktopEntry::readDesktopFile(foreignBuffer, visitor));
+    QVERIFY(visited.isEmpty());
+
+    QByteArray invalid = "[Desktop Entry]\nType=Application\nnot a key\n";
+    QBuffer invalidBuffer(&invalid);
+    invalidBuffer.open(QIODevice::ReadOnly);
+    QVERIFY(!MDesktopEntry::readDesktopFile(invalidBuffer, visitor));
+
+    // Lines split between the chunks of a sequential device are joined.
+    ChunkedDevice pipe(QList<QByteArray>() << "[Desktop Entry]\nTy" << "pe=Application\n", false);
+    visited.clear();
+    QVERIFY(MDesktopEntry::readDesktopFile(pipe, visitor));
+    QCOMPARE(visited, QStringList() << "Desktop Entry/Type=Application");
+
+    ChunkedDevice failing(QList<QByteArray>() << "[Desktop Entry]\nType=Application\n", true);
+    QVERIFY(!MDesktopEntry::readDesktopFile(failing, visitor));
+}
+
+void UtMDesktopEntry::escapes()
+{
+    Values values;
+    values["Comment"] = "\\sLeading\\tspace\\nand\\\\slash";
+    values["Categories"] = "a\\;b;c;;d";
+    values["Icon"] = "invalid\\escape";
+    values["Exec"] = "foo\\;bar";
+
+    MDesktopEntry entry(createDesktopEntry(values));
+    QCOMPARE(entry.comment(), QString(" Leading\tspace\nand\\slash"));
+    QCOMPARE(entry.categories(), QStringList() << "a;b" << "c" << "" << "d");
+    QCOMPARE(entry.icon(), QString());
+    // A semicolon can only be escaped in a list.
+    QCOMPARE(entry.exec(), QString());
+}
+
+void UtMDesktopEntry::whitespace()
+{
+    Values values;
+    values["__tail__"] = "  Key  =   value with trailing  \n"
+                         "\t# indented comment\n"
+                         "Name[fi]  =Nimi\n"
+                         "[Other]   \n"
+                         "Flag=true \n"
+                         "Number=1\n";
+
+    MDesktopEntry entry(createDesktopEntry(values));
+    QVERIFY(entry.contains("Desktop Entry", "Key"));
+    QCOMPARE(entry.value("Desktop Entry", "Key"), QString("value with trailing  "));
+    QCOMPARE(entry.value("Desktop Entry", "Name[fi]"), QString("Nimi"));
+    QVERIFY(entry.contains("Other", "Flag"));
+    QCOMPARE(entry.value("Other/Number"), QString("1"));
+}
+
+void UtMDesktopEntry::loadAll()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+
+    QStringList fileNames;
+    for (int i = 0; i < 50; ++i) {
+        const QString fileName = directory.filePath(QString("entry%1.desktop").arg(i));
+        QFile file(fileName);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        QTextStream out(&file);
+        out << "[Desktop Entry]" << Qt::endl
+            << "Type=Application" << Qt::endl
+            << "Name=Entry " << i << Qt::endl
+            << "Exec=true" << Qt::endl
+            << "Categories=Utility;Office;" << Qt::endl;
+        fileNames << fileName;
+    }
+    fileNames << directory.filePath("missing.desktop");
+
+    const QList<MDesktopEntry> entries = MDesktopEntry::loadAll(fileNames);
+    QCOMPARE(entries.count(), fileNames.count());
+    for (int i = 0; i < 50; ++i) {
+        QCOMPARE(entries.at(i).fileName(), fileNames.at(i));
+        QVERIFY(entries.at(i).isValid());
+        QCOMPARE(entries.at(i).name(), QString("Entry %1").arg(i));
+        QCOMPARE(entries.at(i).categories(), QStringList() << "Utility" << "Office");
+        // Categories are interned when the fields are decoded.
+        QCOMPARE(entries.at(i).categories().first().constData(),
+                 entries.first().categories().first().constData());
+    }
+    QVERIFY(!entries.last().isValid());
+
+    QVERIFY(MDesktopEntry::loadAll(QStringList()).isEmpty());
+}
+
+void UtMDesktopEntry::implicitSharing()
+{
+    Values values;
+    values["Type"] = "Application";
+    values["Name"] = "Shared";
+    values["Exec"] = "true";
+
+    MDesktopEntry entry(createDesktopEntry(values));
+    QVERIFY(entry.isValid());
+
+    const MDesktopEntry copy(entry);
+    QCOMPARE(copy.fileName(), entry.fileName());
+    QCOMPARE(copy.name(), QString("Shared"));
+    // The decoded fields are shared with the copy.
+    QCOMPARE(copy.name().constData(), entry.name().constData());
+
+    MDesktopEntry other(QDir::temp().filePath("ut_mdesktopentry-missing.desktop"));
+    QVERIFY(!other.isValid());
+    other = entry;
+    QVERIFY(other.isValid());
+    QCOMPARE(other.name(), QString("Shared"));
+
+    MDesktopEntry moved(std::move(other));
+    QCOMPARE(moved.name(), QString("Shared"));
+    // The moved-from entry is still usable
+    QVERIFY(!other.isValid());
+    QVERIFY(other.fileName().isEmpty());
+    other = copy;
+    QCOMPARE(other.name(), QString("Shared"));
+
+    const MDesktopEntry empty;
+    QVERIFY(!empty.isValid());
+    QVERIFY(empty.fileName().isEmpty());
+
+    QList<MDesktopEntry> list;
+    list << entry << copy;
+    QCOMPARE(list.last().exec(), QString("true"));
+}
+
 QString UtMDesktopEntry::createDesktopEntry(const Values &values)
 {
     Q_ASSERT(m_temporaryFile == 0);
@@ -0,0 +1,201 @@
+#include <QTest>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QTemporaryDir>
+
+#include "desktopfiletestutils.h"
+#include "mdesktopentrycache.h"
+
+namespace Tests {
+
+class UtMDesktopEntryCache : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void scan();
+    void saveAndLoad();
+    void modifiedFile();
+    void removedFile();
+    void invalidIndex();
+
+private:
+    QTemporaryDir *m_directory;
+    QString m_applications;
+    QString m_indexPath;
+};
+
+} // namespace Tests
+
+using namespace Tests;
+
+void UtMDesktopEntryCache::init()
+{
+    m_directory = new QTemporaryDir;
+    QVERIFY(m_directory->isValid());
+    m_applications = m_directory->path() + QStringLiteral("/applications");
+    m_indexPath = m_directory->path() + QStringLiteral("/cache/desktop.index");
+    QVERIFY(QDir().mkpath(m_applications));
+
+    writeDesktopFile(m_applications, QStringLiteral("first.desktop"),
+                     "[Desktop Entry]\n"
+                     "Type=Application\n"
+                     "Name=First\n"
+                     "Name[fi]=Ensimmäinen\n"
+                     "Exec=first --flag\n"
+                     "Categories=Utility;Office;\n");
+    writeDesktopFile(m_applications, QStringLiteral("second.desktop"),
+                     "[Desktop Entry]\n"
+                     "Type=Application\n"
+                     "Name=Second\n"
+                     "Comment=Line\\nbreak\n"
+                     "Exec=second\n"
+                     "[X-Custom]\n"
+                     "Key=Value\n");
+    writeDesktopFile(m_applications, QStringLiteral("invalid.desktop"),
+                     "[Desktop Entry]\n"
+                     "Name=Invalid\n");
+    writeDesktopFile(m_applications, QStringLiteral("ignored.txt"), "[Desktop Entry]\n");
+}
+
+void UtMDesktopEntryCache::cleanup()
+{
+    delete m_directory;
+    m_directory = 0;
+}
+
+void UtMDesktopEntryCache::scan()
+{
+    MDesktopEntryCache cache(m_indexPath);
+    QVERIFY(cache.fileNames().isEmpty());
+
+    cache.scan(QStringList() << m_applications);
+
+    const QString first = m_applications + QStringLiteral("/first.desktop");
+    const QString second = m_applications + QStringLiteral("/second.desktop");
+    const QString invalid = m_applications + QStringLiteral("/invalid.desktop");
+
+    QCOMPARE(cache.fileNames(), QStringList() << first << invalid << second);
+    QVERIFY(!cache.contains(m_applications + QStringLiteral("/ignored.txt")));
+
+    MDesktopEntry entry = cache.entry(first);
+    QVERIFY(entry.isValid());
+    QCOMPARE(entry.fileName(), first);
+    QCOMPARE(entry.name(), QStringLiteral("First"));
+    QCOMPARE(entry.exec(), QStringLiteral("first --flag"));
+    QCOMPARE(entry.categories(), QStringList() << "Utility" << "Office");
+    // Later calls share the entry built by the first one.
+    QCOMPARE(cache.entry(first).exec().constData(), entry.exec().constData());
+
+    entry = cache.entry(second);
+    QCOMPARE(entry.comment(), QStringLiteral("Line\nbreak"));
+    QCOMPARE(entry.value(QStringLiteral("X-Custom"), QStringLiteral("Key")), QStringLiteral("Value"));
+
+    QVERIFY(!cache.entry(invalid).isValid());
+}
+
+void UtMDesktopEntryCache::saveAndLoad()
+{
+    const QString first = m_applications + QStringLiteral("/first.desktop");
+    const QString second = m_applications + QStringLiteral("/second.desktop");
+    {
+        MDesktopEntryCache cache(m_indexPath);
+        cache.scan(QStringList() << m_applications);
+        QVERIFY(cache.save());
+    }
+    QVERIFY(QFile::exists(m_indexPath));
+
+    MDesktopEntryCache cache(m_indexPath);
+    QCOMPARE(cache.fileNames().count(), 3);
+
+    MDesktopEntry entry = cache.entry(first);
+    QVERIFY(entry.isValid());
+    QCOMPARE(entry.name(), QStringLiteral("First"));
+    QCOMPARE(entry.value(QStringLiteral("Desktop Entry"), QStringLiteral("Name[fi]")),
+             QStringLiteral("Ensimmäinen"));
+    QCOMPARE(entry.categories(), QStringList() << "Utility" << "Office");
+
+    entry = cache.entry(second);
+    QCOMPARE(entry.comment(), QStringLiteral("Line\nbreak"));
+    QCOMPARE(entry.value(QStringLiteral("X-Custom"), QStringLiteral("Key")), QStringLiteral("Value"));
+
+    QVERIFY(!cache.entry(m_applications + QStringLiteral("/invalid.desktop")).isValid());
+
+    // Unchanged files don't make the index dirty, saving the loaded index again keeps the values.
+    cache.scan(QStringList() << m_applications);
+    QVERIFY(cache.save());
+    QCOMPARE(cache.entry(first).name(), QStringLiteral("First"));
+}
+
+void UtMDesktopEntryCache::modifiedFile()
+{
+    {
+        MDesktopEntryCache cache(m_indexPath);
+        cache.scan(QStringList() << m_applications);
+        QVERIFY(cache.save());
+    }
+
+    const QString first = writeDesktopFile(m_applications, QStringLiteral("first.desktop"),
+                                           "[Desktop Entry]\n"
+                                           "Type=Application\n"
+                                           "Name=Renamed first\n"
+                                           "Exec=first\n");
+
+    MDesktopEntryCache cache(m_indexPath);
+    cache.scan(QStringList() << m_applications);
+    QCOMPARE(cache.entry(first).name(), QStringLiteral("Renamed first"));
+    QVERIFY(cache.save());
+
+    MDesktopEntryCache reloaded(m_indexPath);
+    QCOMPARE(reloaded.entry(first).name(), QStringLiteral("Renamed first"));
+    QCOMPARE(reloaded.entry(m_applications + QStringLiteral("/second.desktop")).name(),
+             QStringLiteral("Second"));
+}
+
+void UtMDesktopEntryCache::removedFile()
+{
+    const QString second = m_applications + QStringLiteral("/second.desktop");
+    {
+        MDesktopEntryCache cache(m_indexPath);
+        cache.scan(QStringList() << m_applications);
+        QVERIFY(cache.save());
+    }
+
+    QVERIFY(QFile::remove(second));
+
+    MDesktopEntryCache cache(m_indexPath);
+    QVERIFY(cache.contains(second));
+    cache.scan(QStringList() << m_applications);
+    QVERIFY(!cache.contains(second));
+    QVERIFY(cache.save());
+
+    MDesktopEntryCache reloaded(m_indexPath);
+    QCOMPARE(reloaded.fileNames().count(), 2);
+    QVERIFY(!reloaded.contains(second));
+}
+
+void UtMDesktopEntryCache::invalidIndex()
+{
+    QVERIFY(QDir().mkpath(QFileInfo(m_indexPath).absolutePath()));
+    QFile file(m_indexPath);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("not a desktop entry index");
+    file.close();
+
+    MDesktopEntryCache cache(m_indexPath);
+    QVERIFY(cache.fileNames().isEmpty());
+
+    cache.scan(QStringList() << m_applications);
+    QCOMPARE(cache.fileNames().count(), 3);
+    QVERIFY(cache.save());
+
+    MDesktopEntryCache reloaded(m_indexPath);
+    QCOMPARE(reloaded.fileNames().count(), 3);
+}
+
+QTEST_MAIN(Tests::UtMDesktopEntryCache)
+
+#include "ut_mdesktopentrycache.moc"
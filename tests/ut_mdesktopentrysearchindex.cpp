@@ -0,0 +1,158 @@
+#include <QTest>
+#include <QtCore/QScopedPointer>
+#include <QtCore/QTemporaryDir>
+
+#include "desktopfiletestutils.h"
+#include "mdesktopentrysearchindex.h"
+
+namespace Tests {
+
+class UtMDesktopEntrySearchIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void prefixSearch();
+    void ranking();
+    void allWordsMatch();
+    void limit();
+    void insertAndRemove();
+    void localizedFields();
+
+private:
+    QScopedPointer<QTemporaryDir> m_directory;
+    QScopedPointer<MDesktopEntrySearchIndex> m_index;
+};
+
+} // namespace Tests
+
+using namespace Tests;
+
+void UtMDesktopEntrySearchIndex::init()
+{
+    m_directory.reset(new QTemporaryDir);
+    QVERIFY(m_directory->isValid());
+    m_index.reset(new MDesktopEntrySearchIndex);
+
+    m_index->insert(createEntry(m_directory->path(), "browser",
+                                "Name=Web Browser\n"
+                                "GenericName=Internet\n"
+                                "Keywords=www;surf;\n"
+                                "Categories=Network;WebBrowser;\n"
+                                "MimeType=text/html;\n"
+                                "Exec=/usr/bin/sailfish-browser %U\n"));
+    m_index->insert(createEntry(m_directory->path(), "mail",
+                                "Name=Mail\n"
+                                "Comment=Read and write email on the web\n"
+                                "Categories=Network;Email;\n"
+                                "Exec=jolla-email\n"));
+    m_index->insert(createEntry(m_directory->path(), "notes",
+                                "Name=Notes\n"
+                                "Comment=Write down notes\n"
+                                "Categories=Office;\n"
+                                "Exec=jolla-notes\n"));
+    m_index->insert(createEntry(m_directory->path(), "network",
+                                "Name=Network Settings\n"
+                                "Categories=Settings;\n"
+                                "Exec=jolla-settings network\n"));
+}
+
+void UtMDesktopEntrySearchIndex::cleanup()
+{
+    m_index.reset();
+    m_directory.reset();
+}
+
+void UtMDesktopEntrySearchIndex::prefixSearch()
+{
+    QCOMPARE(m_index->count(), 4);
+
+    QCOMPARE(entryNames(m_index->search("brow")), QStringList() << "Web Browser");
+    QCOMPARE(entryNames(m_index->search("BROWSER")), QStringList() << "Web Browser");
+    QCOMPARE(entryNames(m_index->search("surf")), QStringList() << "Web Browser");
+    QCOMPARE(entryNames(m_index->search("sailfish")), QStringList() << "Web Browser");
+    QCOMPARE(entryNames(m_index->search("html")), QStringList() << "Web Browser");
+    QCOMPARE(entryNames(m_index->search("office")), QStringList() << "Notes");
+    QVERIFY(m_index->search("nothing").isEmpty());
+    QVERIFY(m_index->search("").isEmpty());
+    QVERIFY(m_index->search(" ; ").isEmpty());
+}
+
+void UtMDesktopEntrySearchIndex::ranking()
+{
+    // A name match ranks above a category match, equal scores are sorted by name.
+    QCOMPARE(entryNames(m_index->search("net")), QStringList() << "Network Settings" << "Mail" << "Web Browser");
+    QCOMPARE(entryNames(m_index->search("web")), QStringList() << "Web Browser" << "Mail");
+    QCOMPARE(entryNames(m_index->search("write")), QStringList() << "Mail" << "Notes");
+    QCOMPARE(entryNames(m_index->search("note")), QStringList() << "Notes");
+}
+
+void UtMDesktopEntrySearchIndex::allWordsMatch()
+{
+    QCOMPARE(entryNames(m_index->search("web mail")), QStringList() << "Mail");
+    QCOMPARE(entryNames(m_index->search("write notes")), QStringList() << "Notes");
+    QVERIFY(m_index->search("web office").isEmpty());
+}
+
+void UtMDesktopEntrySearchIndex::limit()
+{
+    QCOMPARE(m_index->search("net").count(), 3);
+    QCOMPARE(entryNames(m_index->search("net", 1)), QStringList() << "Network Settings");
+    QVERIFY(m_index->search("net", 0).isEmpty());
+}
+
+void UtMDesktopEntrySearchIndex::insertAndRemove()
+{
+    const MDesktopEntry mail = m_index->search("mail").first();
+
+    m_index->remove(mail.fileName());
+    QCOMPARE(m_index->count(), 3);
+    QVERIFY(m_index->search("mail").isEmpty());
+    QCOMPARE(entryNames(m_index->search("net")), QStringList() << "Network Settings" << "Web Browser");
+
+    // Replacing an entry drops the words of the old one.
+    m_index->insert(createEntry(m_directory->path(), "notes", "Name=Memo\nExec=jolla-notes\n"));
+    QCOMPARE(m_index->count(), 3);
+    QVERIFY(m_index->search("office").isEmpty());
+    QCOMPARE(entryNames(m_index->search("memo")), QStringList() << "Memo");
+
+    m_index->insert(mail);
+    QCOMPARE(m_index->count(), 4);
+    QCOMPARE(entryNames(m_index->search("mail")), QStringList() << "Mail");
+
+    m_index->clear();
+    QCOMPARE(m_index->count(), 0);
+    QVERIFY(m_index->search("net").isEmpty());
+}
+
+void UtMDesktopEntrySearchIndex::localizedFields()
+{
+    const QByteArray lang = qgetenv("LANG");
+    unsetenv("LANGUAGE");
+    unsetenv("LC_ALL");
+    unsetenv("LC_MESSAGES");
+    qputenv("LANG", "fi_FI");
+
+    m_index->insert(createEntry(m_directory->path(), "clock",
+                                "Name=Clock\n"
+                                "Name[fi]=Kello\n"
+                                "GenericName=Alarm clock\n"
+                                "GenericName[fi]=Herätyskello\n"
+                                "Comment=Wake up in time\n"
+                                "Comment[fi]=Heräät ajoissa\n"
+                                "Exec=jolla-clock\n"));
+
+    qputenv("LANG", lang);
+
+    // The translated generic name and comment are searched, not the untranslated ones
+    QCOMPARE(m_index->search("herätys").count(), 1);
+    QCOMPARE(m_index->search("ajoissa").count(), 1);
+    QVERIFY(m_index->search("alarm").isEmpty());
+    QVERIFY(m_index->search("wake").isEmpty());
+}
+
+QTEST_MAIN(Tests::UtMDesktopEntrySearchIndex)
+
+#include "ut_mdesktopentrysearchindex.moc"
@@ -0,0 +1,122 @@
+#include <QTest>
+#include <QtCore/QScopedPointer>
+#include <QtCore/QTemporaryDir>
+
+#include "desktopfiletestutils.h"
+#include "mdesktopentrytypeindex.h"
+
+namespace Tests {
+
+class UtMDesktopEntryTypeIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void mimeTypes();
+    void wildcardMimeTypes();
+    void categories();
+    void insertAndRemove();
+
+private:
+    QScopedPointer<QTemporaryDir> m_directory;
+    QScopedPointer<MDesktopEntryTypeIndex> m_index;
+};
+
+} // namespace Tests
+
+using namespace Tests;
+
+void UtMDesktopEntryTypeIndex::init()
+{
+    m_directory.reset(new QTemporaryDir);
+    QVERIFY(m_directory->isValid());
+    m_index.reset(new MDesktopEntryTypeIndex);
+
+    m_index->insert(createEntry(m_directory->path(), "gallery",
+                                "Exec=true\n"
+                                "Name=Gallery\n"
+                                "Categories=Graphics;Viewer;\n"
+                                "MimeType=image/jpeg;image/png;Video/MP4;\n"));
+    m_index->insert(createEntry(m_directory->path(), "editor",
+                                "Exec=true\n"
+                                "Name=Editor\n"
+                                "Categories=Graphics;\n"
+                                "MimeType=image/*;\n"));
+    m_index->insert(createEntry(m_directory->path(), "game",
+                                "Exec=true\n"
+                                "Name=Game\n"
+                                "Categories=Game;Game;\n"));
+}
+
+void UtMDesktopEntryTypeIndex::cleanup()
+{
+    m_index.reset();
+    m_directory.reset();
+}
+
+void UtMDesktopEntryTypeIndex::mimeTypes()
+{
+    QCOMPARE(m_index->count(), 3);
+
+    QCOMPARE(entryNames(m_index->entriesForMimeType("video/mp4")), QStringList() << "Gallery");
+    QCOMPARE(entryNames(m_index->entriesForMimeType("VIDEO/mp4")), QStringList() << "Gallery");
+    QVERIFY(m_index->entriesForMimeType("text/plain").isEmpty());
+    QVERIFY(m_index->entriesForMimeType(QString()).isEmpty());
+
+    QStringList types = m_index->mimeTypes();
+    types.sort();
+    QCOMPARE(types, QStringList() << "image/*" << "image/jpeg" << "image/png" << "video/mp4");
+}
+
+void UtMDesktopEntryTypeIndex::wildcardMimeTypes()
+{
+    QCOMPARE(entryNames(m_index->entriesForMimeType("image/jpeg")), QStringList() << "Gallery" << "Editor");
+    QCOMPARE(entryNames(m_index->entriesForMimeType("image/gif")), QStringList() << "Editor");
+    QCOMPARE(entryNames(m_index->entriesForMimeType("image/*")), QStringList() << "Editor");
+}
+
+void UtMDesktopEntryTypeIndex::categories()
+{
+    QCOMPARE(entryNames(m_index->entriesInCategory("Graphics")), QStringList() << "Gallery" << "Editor");
+    QCOMPARE(entryNames(m_index->entriesInCategory("Game")), QStringList() << "Game");
+    QVERIFY(m_index->entriesInCategory("game").isEmpty());
+
+    QStringList categories = m_index->categories();
+    categories.sort();
+    QCOMPARE(categories, QStringList() << "Game" << "Graphics" << "Viewer");
+}
+
+void UtMDesktopEntryTypeIndex::insertAndRemove()
+{
+    const MDesktopEntry gallery = m_index->entriesInCategory("Viewer").first();
+
+    m_index->remove(gallery.fileName());
+    QCOMPARE(m_index->count(), 2);
+    QVERIFY(m_index->entriesInCategory("Viewer").isEmpty());
+    QVERIFY(!m_index->categories().contains("Viewer"));
+    QCOMPARE(entryNames(m_index->entriesForMimeType("image/png")), QStringList() << "Editor");
+    QVERIFY(m_index->entriesForMimeType("video/mp4").isEmpty());
+
+    // Replacing an entry drops the types of the old one.
+    m_index->insert(createEntry(m_directory->path(), "editor",
+                                "Exec=true\nName=Editor\nCategories=Office;\nMimeType=text/plain;\n"));
+    QCOMPARE(m_index->count(), 2);
+    QVERIFY(m_index->entriesInCategory("Graphics").isEmpty());
+    QVERIFY(m_index->entriesForMimeType("image/png").isEmpty());
+    QCOMPARE(entryNames(m_index->entriesForMimeType("text/plain")), QStringList() << "Editor");
+
+    m_index->insert(gallery);
+    QCOMPARE(m_index->count(), 3);
+    QCOMPARE(entryNames(m_index->entriesForMimeType("image/png")), QStringList() << "Gallery");
+
+    m_index->clear();
+    QCOMPARE(m_index->count(), 0);
+    QVERIFY(m_index->mimeTypes().isEmpty());
+    QVERIFY(m_index->categories().isEmpty());
+}
+
+QTEST_MAIN(Tests::UtMDesktopEntryTypeIndex)
+
+#include "ut_mdesktopentrytypeindex.moc"
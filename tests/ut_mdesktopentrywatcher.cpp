@@ -0,0 +1,177 @@
+#include <QTest>
+#include <QtTest/QSignalSpy>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QTemporaryDir>
+
+#include "desktopfiletestutils.h"
+#include "mdesktopentrywatcher.h"
+
+namespace Tests {
+
+class UtMDesktopEntryWatcher : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void initialEntries();
+    void addChangeRemove();
+    void coalesce();
+    void setDirectories();
+    void recreatedDirectory();
+
+private:
+    QString writeEntry(const QString &directory, const QString &name, const QString &entryName);
+
+    QTemporaryDir *m_directory;
+    QString m_applications;
+    QString m_other;
+};
+
+} // namespace Tests
+
+using namespace Tests;
+
+void UtMDesktopEntryWatcher::init()
+{
+    m_directory = new QTemporaryDir;
+    QVERIFY(m_directory->isValid());
+    m_applications = m_directory->path() + QStringLiteral("/applications");
+    m_other = m_directory->path() + QStringLiteral("/other");
+    QVERIFY(QDir().mkpath(m_applications));
+    QVERIFY(QDir().mkpath(m_other));
+
+    writeEntry(m_applications, QStringLiteral("first.desktop"), QStringLiteral("First"));
+}
+
+void UtMDesktopEntryWatcher::cleanup()
+{
+    delete m_directory;
+    m_directory = 0;
+}
+
+QString UtMDesktopEntryWatcher::writeEntry(
+        const QString &directory, const QString &name, const QString &entryName)
+{
+    return writeDesktopFile(directory, name, applicationEntry("Exec=true\nName=" + entryName.toUtf8() + "\n"));
+}
+
+void UtMDesktopEntryWatcher::initialEntries()
+{
+    writeEntry(m_applications, QStringLiteral("ignored.txt"), QStringLiteral("Ignored"));
+
+    MDesktopEntryWatcher watcher(QStringList() << m_applications);
+    QCOMPARE(watcher.directories(), QStringList() << m_applications);
+
+    const QString first = m_applications + QStringLiteral("/first.desktop");
+    QCOMPARE(watcher.fileNames(), QStringList() << first);
+    QVERIFY(watcher.entry(first).isValid());
+    QCOMPARE(watcher.entry(first).name(), QStringLiteral("First"));
+    QVERIFY(watcher.entry(m_applications + QStringLiteral("/ignored.txt")).fileName().isEmpty());
+}
+
+void UtMDesktopEntryWatcher::addChangeRemove()
+{
+    MDesktopEntryWatcher watcher(QStringList() << m_applications);
+    watcher.setCoalesceInterval(20);
+
+    QSignalSpy addedSpy(&watcher, SIGNAL(entryAdded(QString)));
+    QSignalSpy changedSpy(&watcher, SIGNAL(entryChanged(QString)));
+    QSignalSpy removedSpy(&watcher, SIGNAL(entryRemoved(QString)));
+
+    const QString second = writeEntry(m_applications, QStringLiteral("second.desktop"), QStringLiteral("Second"));
+    QTRY_COMPARE(addedSpy.count(), 1);
+    QCOMPARE(addedSpy.first().first().toString(), second);
+    QCOMPARE(watcher.entry(second).name(), QStringLiteral("Second"));
+
+    writeEntry(m_applications, QStringLiteral("second.desktop"), QStringLiteral("Renamed"));
+    QTRY_COMPARE(changedSpy.count(), 1);
+    QCOMPARE(changedSpy.first().first().toString(), second);
+    QCOMPARE(watcher.entry(second).name(), QStringLiteral("Renamed"));
+
+    QVERIFY(QFile::remove(second));
+    QTRY_COMPARE(removedSpy.count(), 1);
+    QCOMPARE(removedSpy.first().first().toString(), second);
+    QVERIFY(watcher.entry(second).fileName().isEmpty());
+
+    QCOMPARE(addedSpy.count(), 1);
+    QCOMPARE(changedSpy.count(), 1);
+}
+
+void UtMDesktopEntryWatcher::coalesce()
+{
+    MDesktopEntryWatcher watcher(QStringList() << m_applications);
+    watcher.setCoalesceInterval(100);
+
+    QSignalSpy addedSpy(&watcher, SIGNAL(entryAdded(QString)));
+    QSignalSpy changedSpy(&watcher, SIGNAL(entryChanged(QString)));
+
+    // Each file is touched several times, but only reported once.
+    for (int i = 0; i < 20; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            writeEntry(m_applications, QString("burst%1.desktop").arg(i), QString("Burst %1").arg(j));
+        }
+    }
+
+    QTRY_COMPARE(addedSpy.count(), 20);
+    QTest::qWait(300);
+    QCOMPARE(addedSpy.count(), 20);
+    QCOMPARE(changedSpy.count(), 0);
+    QCOMPARE(watcher.fileNames().count(), 21);
+    QCOMPARE(watcher.entry(m_applications + QStringLiteral("/burst7.desktop")).name(), QStringLiteral("Burst 2"));
+}
+
+void UtMDesktopEntryWatcher::setDirectories()
+{
+    writeEntry(m_other, QStringLiteral("other.desktop"), QStringLiteral("Other"));
+
+    MDesktopEntryWatcher watcher;
+    watcher.setCoalesceInterval(20);
+    QSignalSpy directoriesSpy(&watcher, SIGNAL(directoriesChanged()));
+    QSignalSpy addedSpy(&watcher, SIGNAL(entryAdded(QString)));
+
+    watcher.setDirectories(QStringList() << m_applications << m_other);
+    QCOMPARE(directoriesSpy.count(), 1);
+    QCOMPARE(watcher.fileNames().count(), 2);
+    QCOMPARE(addedSpy.count(), 0);
+
+    watcher.setDirectories(QStringList() << m_other);
+    QCOMPARE(directoriesSpy.count(), 2);
+    QCOMPARE(watcher.fileNames(), QStringList() << m_other + QStringLiteral("/other.desktop"));
+
+    // The directory which is no longer watched is ignored.
+    writeEntry(m_applications, QStringLiteral("ignored.desktop"), QStringLiteral("Ignored"));
+    const QString added = writeEntry(m_other, QStringLiteral("added.desktop"), QStringLiteral("Added"));
+    QTRY_COMPARE(addedSpy.count(), 1);
+    QCOMPARE(addedSpy.first().first().toString(), added);
+    QCOMPARE(watcher.fileNames().count(), 2);
+}
+
+void UtMDesktopEntryWatcher::recreatedDirectory()
+{
+    MDesktopEntryWatcher watcher(QStringList() << m_applications);
+    watcher.setCoalesceInterval(20);
+    QSignalSpy addedSpy(&watcher, SIGNAL(entryAdded(QString)));
+    QSignalSpy removedSpy(&watcher, SIGNAL(entryRemoved(QString)));
+
+    QVERIFY(QDir(m_applications).removeRecursively());
+    QTRY_COMPARE(removedSpy.count(), 1);
+    QVERIFY(watcher.fileNames().isEmpty());
+
+    // Entries of the recreated directory are picked up, also the ones written right away.
+    QVERIFY(QDir().mkpath(m_applications));
+    const QString second = writeEntry(m_applications, QStringLiteral("second.desktop"), QStringLiteral("Second"));
+    QTRY_COMPARE(addedSpy.count(), 1);
+    QCOMPARE(addedSpy.first().first().toString(), second);
+
+    const QString third = writeEntry(m_applications, QStringLiteral("third.desktop"), QStringLiteral("Third"));
+    QTRY_COMPARE(addedSpy.count(), 2);
+    QCOMPARE(addedSpy.last().first().toString(), third);
+    QCOMPARE(watcher.directories(), QStringList() << m_applications);
+}
+
+QTEST_MAIN(Tests::UtMDesktopEntryWatcher)
+
+#include "ut_mdesktopentrywatcher.moc"
@@ -34,9 +34,17 @@ private slots:
     void otherProcessSetValue();
     void otherProcessCreateOtherValue();
     void otherProcessSetAndRemoveValue();
+    void writesReplaceFile();
+    void deferredWrites();
+    void batchedWrites();
+    void flushOnDestruction();
+    void externalChangesSignaled();
+    void sharedDirectory();
+    void failedWriteRecovers();
 
 private:
     static QString filePath();
+    static QByteArray readFile();
     static bool writeFile(const QByteArray &data);
 };
 
@@ -370,12 +378,191 @@ void UtMFileDataStore::otherProcessSetAndRemoveValue()
     QCOMPARE(store2.value("baz").toString(), QString("nobar"));
 }
 
+void UtMFileDataStore::writesReplaceFile()
+{
+    MFileDataStore store(filePath());
+
+    QVERIFY(store.createValue("foo", "bar"));
+    QVERIFY(store.createValue("list", QStringList() << "a" << "b"));
+    QVERIFY(store.setValue("foo", "baz"));
+    store.remove("list");
+
+    QFile file(filePath());
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(file.readAll(), QByteArray("[General]\nfoo=baz\n"));
+
+    // The temporary files the settings were written to have been renamed over the file.
+    const QFileInfo info(filePath());
+    QCOMPARE(info.dir().entryList(QStringList() << info.fileName() + "*", QDir::Files),
+             QStringList() << info.fileName());
+}
+
+void UtMFileDataStore::deferredWrites()
+{
+    MFileDataStore store(filePath());
+    QCOMPARE(store.flushDelay(), -1);
+    store.setFlushDelay(50);
+    QCOMPARE(store.flushDelay(), 50);
+
+    QSignalSpy spy(&store, SIGNAL(valueChanged(QString, QVariant)));
+    for (int i = 0; i < 10; ++i)
+        QVERIFY(store.createValue(QString("key%1").arg(i), i));
+
+    // The changes are visible and signaled at once, but not written yet.
+    QCOMPARE(spy.count(), 10);
+    QCOMPARE(store.value("key9").toInt(), 9);
+    QVERIFY(!readFile().contains("key"));
+
+    QTRY_VERIFY(readFile().contains("key9=9"));
+
+    QVERIFY(store.setValue("key0", 100));
+    QVERIFY(!readFile().contains("key0=100"));
+    QVERIFY(store.flush());
+    QVERIFY(readFile().contains("key0=100"));
+    QCOMPARE(spy.count(), 11);
+}
+
+void UtMFileDataStore::batchedWrites()
+{
+    MFileDataStore store(filePath());
+    QSignalSpy spy(&store, SIGNAL(valueChanged(QString, QVariant)));
+
+    store.beginBatch();
+    QVERIFY(store.createValue("foo", "bar"));
+    store.beginBatch();
+    QVERIFY(store.createValue("baz", "qux"));
+    QVERIFY(store.endBatch());
+    store.remove("foo");
+    QCOMPARE(spy.count(), 3);
+    QVERIFY(!readFile().contains("baz"));
+
+    QVERIFY(store.endBatch());
+    QCOMPARE(readFile(), QByteArray("[General]\nbaz=qux\n"));
+
+    // Without a flush delay, changes outside a batch are written immediately again.
+    QVERIFY(store.setValue("baz", "quux"));
+    QCOMPARE(readFile(), QByteArray("[General]\nbaz=quux\n"));
+}
+
+void UtMFileDataStore::flushOnDestruction()
+{
+    {
+        MFileDataStore store(filePath());
+        store.setFlushDelay(60000);
+        QVERIFY(store.createValue("foo", "bar"));
+        QVERIFY(!readFile().contains("foo"));
+    }
+    QCOMPARE(readFile(), QByteArray("[General]\nfoo=bar\n"));
+}
+
+void UtMFileDataStore::externalChangesSignaled()
+{
+    MFileDataStore store(filePath());
+    QVERIFY(store.createValue("a", "1"));
+    QVERIFY(store.createValue("b", "2"));
+    QVERIFY(store.createValue("c", "3"));
+    QTest::qWait(100);
+
+    QSignalSpy spy(&store, SIGNAL(valueChanged(QString, QVariant)));
+
+    // Only the changed, removed and added keys are signaled
+    const QByteArray data("[General]\na=1\nb=changed\nd=4\n");
+    QVERIFY(writeFile(data));
+    QTRY_COMPARE(spy.count(), 3);
+    QCOMPARE(spy.at(0).at(0).toString(), QString("b"));
+    QCOMPARE(spy.at(0).at(1).toString(), QString("changed"));
+    QCOMPARE(spy.at(1).at(0).toString(), QString("c"));
+    QVERIFY(!spy.at(1).at(1).isValid());
+    QCOMPARE(spy.at(2).at(0).toString(), QString("d"));
+    QCOMPARE(spy.at(2).at(1).toString(), QString("4"));
+
+    // Rewriting the same content doesn't signal anything
+    QVERIFY(writeFile(data));
+    QTest::qWait(100);
+    QCOMPARE(spy.count(), 3);
+
+    // Nor do the notifications of our own writes
+    QVERIFY(store.setValue("a", "5"));
+    QCOMPARE(spy.count(), 4);
+    QTest::qWait(100);
+    QCOMPARE(spy.count(), 4);
+}
+
+void UtMFileDataStore::sharedDirectory()
+{
+    const QString otherPath = filePath() + ".other";
+    QFile::remove(otherPath);
+
+    MFileDataStore store1(filePath());
+    MFileDataStore store2(filePath());
+    MFileDataStore other(otherPath);
+    QVERIFY(store1.createValue("foo", "bar"));
+    QVERIFY(other.createValue("foo", "bar"));
+    QTest::qWait(100);
+
+    QSignalSpy spy1(&store1, SIGNAL(valueChanged(QString, QVariant)));
+    QSignalSpy spy2(&store2, SIGNAL(valueChanged(QString, QVariant)));
+    QSignalSpy otherSpy(&other, SIGNAL(valueChanged(QString, QVariant)));
+
+    // Only the stores of the changed file are notified
+    QVERIFY(writeFile("[General]\nfoo=changed\n"));
+    QTRY_COMPARE(spy1.count(), 1);
+    QTRY_COMPARE(spy2.count(), 1);
+    QTest::qWait(100);
+    QCOMPARE(otherSpy.count(), 0);
+    QCOMPARE(other.value("foo").toString(), QString("bar"));
+
+    QVERIFY(QFile::remove(otherPath));
+    QTRY_COMPARE(otherSpy.count(), 1);
+    QCOMPARE(spy1.count(), 1);
+}
+
+void UtMFileDataStore::failedWriteRecovers()
+{
+    QVERIFY(writeFile("[General]\nfoo=bar\n"));
+    MFileDataStore store(filePath());
+    QSignalSpy spy(&store, SIGNAL(valueChanged(QString, QVariant)));
+
+    // The file stays writable, but its replacement can't be created in a read-only directory.
+    const QString directory = QFileInfo(filePath()).absolutePath();
+    const QFile::Permissions permissions = QFile::permissions(directory);
+    QVERIFY(QFile::setPermissions(directory, QFile::ReadOwner | QFile::ExeOwner));
+    QFile probe(directory + "/probe");
+    if (probe.open(QIODevice::WriteOnly)) {
+        probe.remove();
+        QFile::setPermissions(directory, permissions);
+        QSKIP("Directory permissions are not enforced for this user");
+    }
+
+    QVERIFY(store.isWritable());
+    QVERIFY(!store.setValue("foo", "failed"));
+    QVERIFY(!store.createValue("baz", "failed"));
+    QVERIFY(QFile::setPermissions(directory, permissions));
+
+    // The failure isn't remembered, the values are as before and writing works again.
+    QVERIFY(store.isReadable());
+    QVERIFY(store.isWritable());
+    QCOMPARE(store.value("foo").toString(), QString("bar"));
+    QVERIFY(!store.contains("baz"));
+    QCOMPARE(spy.count(), 0);
+
+    QVERIFY(store.setValue("foo", "written"));
+    QCOMPARE(readFile(), QByteArray("[General]\nfoo=written\n"));
+    QCOMPARE(spy.count(), 1);
+}
+
 QString UtMFileDataStore::filePath()
 {
     return QDir::temp().filePath(QString("ut_mfiledatastore/%1.ini")
             .arg(QTest::currentTestFunction()));
 }
 
+QByteArray UtMFileDataStore::readFile()
+{
+    QFile file(filePath());
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
 bool UtMFileDataStore::writeFile(const QByteArray &data)
 {
     QFile file(filePath());
@@ -0,0 +1,236 @@
+#include <QTest>
+#include <QtCore/QAtomicInt>
+#include <QtCore/QFile>
+#include <QtCore/QRunnable>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QThreadPool>
+
+#include "mdesktopentry.h"
+#include "mpermissioncatalog.h"
+
+namespace Tests {
+
+class UtMPermissionCatalog : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void permission();
+    void names();
+    void fromDesktopEntry();
+    void fromFileName();
+    void headerFields();
+    void reload();
+    void concurrentDescriptions();
+
+private:
+    void writeFile(const QString &fileName, const QByteArray &contents);
+    void writePermission(const QString &name, const QByteArray &description);
+
+    QTemporaryDir *m_directory;
+    MPermissionCatalog *m_catalog;
+};
+
+} // namespace Tests
+
+using namespace Tests;
+
+void UtMPermissionCatalog::init()
+{
+    m_directory = new QTemporaryDir;
+    QVERIFY(m_directory->isValid());
+
+    writePermission("Camera", "Use the camera");
+    writePermission("Audio", "Play audio");
+    writeFile(m_directory->path() + "/Broken.permission", "# x-sailjail-long-description = Nothing\n");
+    writeFile(m_directory->path() + "/Other.profile", "# x-sailjail-description = Not a permission\n");
+
+    m_catalog = new MPermissionCatalog(m_directory->path() + "/");
+}
+
+void UtMPermissionCatalog::cleanup()
+{
+    delete m_catalog;
+    m_catalog = 0;
+    delete m_directory;
+    m_directory = 0;
+}
+
+void UtMPermissionCatalog::writeFile(const QString &fileName, const QByteArray &contents)
+{
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write(contents);
+}
+
+void UtMPermissionCatalog::writePermission(const QString &name, const QByteArray &description)
+{
+    writeFile(m_directory->path() + "/" + name + ".permission",
+              "# -*- mode: sh -*-\n"
+              "# x-sailjail-description = " + description + "\n"
+              "# x-sailjail-long-description = " + description + " at any time\n"
+              "\n"
+              "whitelist /dev/null\n");
+}
+
+void UtMPermissionCatalog::permission()
+{
+    QCOMPARE(m_catalog->directory(), m_directory->path());
+
+    const MPermission camera = m_catalog->permission("Camera");
+    QVERIFY(camera.isValid());
+    QCOMPARE(camera.name(), QString("Camera"));
+    QCOMPARE(camera.description(), QString("Use the camera"));
+    QCOMPARE(camera.longDescription(), QString("Use the camera at any time"));
+
+    MPermission copy(camera);
+    QCOMPARE(copy.descriptionUnlocalized(), QString("Use the camera"));
+    // The permission data is shared between copies.
+    QCOMPARE(copy.descriptionUnlocalized().constData(), camera.descriptionUnlocalized().constData());
+
+    copy = m_catalog->permission("Audio");
+    QCOMPARE(copy.name(), QString("Audio"));
+    QCOMPARE(camera.name(), QString("Camera"));
+
+    MPermission moved(std::move(copy));
+    QCOMPARE(moved.name(), QString("Audio"));
+    // The moved-from permission is still usable
+    QVERIFY(!copy.isValid());
+    QVERIFY(copy.name().isEmpty());
+    copy = camera;
+    QCOMPARE(copy.name(), QString("Camera"));
+
+    QVERIFY(!m_catalog->permission("Broken").isValid());
+
+    const MPermission missing = m_catalog->permission("Missing");
+    QVERIFY(!missing.isValid());
+    QCOMPARE(missing.name(), QString("Missing"));
+    QVERIFY(missing.description().isEmpty());
+}
+
+void UtMPermissionCatalog::names()
+{
+    QCOMPARE(m_catalog->names(), QStringList() << "Audio" << "Camera");
+}
+
+void UtMPermissionCatalog::fromDesktopEntry()
+{
+    const QString fileName = m_directory->path() + "/app.desktop";
+    writeFile(fileName,
+              "[Desktop Entry]\n"
+              "Type=Application\n"
+              "Name=App\n"
+              "Exec=app\n"
+              "[X-Sailjail]\n"
+              "Permissions=Camera;!Audio.permission;?Missing;Broken\n");
+
+    const MDesktopEntry entry(fileName);
+    const QList<MPermission> permissions = m_catalog->fromDesktopEntry(entry);
+    QCOMPARE(permissions.count(), 2);
+    QCOMPARE(permissions.at(0).name(), QString("Camera"));
+    QCOMPARE(permissions.at(1).name(), QString("Audio"));
+    QCOMPARE(permissions.at(1).description(), QString("Play audio"));
+}
+
+void UtMPermissionCatalog::fromFileName()
+{
+    const MPermission camera(m_directory->path() + "/Camera.permission");
+    QVERIFY(camera.isValid());
+    QCOMPARE(camera.description(), QString("Use the camera"));
+
+    const MPermission missing(m_directory->path() + "/Missing.permission");
+    QVERIFY(!missing.isValid());
+}
+
+void UtMPermissionCatalog::headerFields()
+{
+    writeFile(m_directory->path() + "/Spaced.permission",
+              "\n"
+              "#x-sailjail-description=No spaces\r\n"
+              "#   x-sailjail-long-description   =   Spaces \t\n"
+              "# x-sailjail-unknown = Ignored\n"
+              "# x-sailjail-description\n");
+    // Only the comment block at the start of the file is read.
+    writeFile(m_directory->path() + "/Late.permission",
+              "# -*- mode: sh -*-\n"
+              "include /etc/sailjail/permissions/Base.permission\n"
+              "# x-sailjail-description = Too late\n");
+    m_catalog->reload();
+
+    const MPermission spaced = m_catalog->permission("Spaced");
+    QCOMPARE(spaced.descriptionUnlocalized(), QString("No spaces"));
+    QCOMPARE(spaced.longDescriptionUnlocalized(), QString("Spaces"));
+
+    QVERIFY(!m_catalog->permission("Late").isValid());
+}
+
+void UtMPermissionCatalog::reload()
+{
+    QCOMPARE(m_catalog->permission("Camera").description(), QString("Use the camera"));
+
+    // Changes are picked up when the directory modification time changes.
+    QTest::qSleep(50);
+    writePermission("Location", "Use the location");
+    QVERIFY(QFile::remove(m_directory->path() + "/Audio.permission"));
+    QCOMPARE(m_catalog->names(), QStringList() << "Camera" << "Location");
+    QCOMPARE(m_catalog->permission("Location").description(), QString("Use the location"));
+    QVERIFY(!m_catalog->permission("Audio").isValid());
+
+    // A file rewritten in place is picked up although the directory didn't change.
+    writePermission("Camera", "Take photos");
+    QCOMPARE(m_catalog->permission("Camera").description(), QString("Take photos"));
+
+    writePermission("Camera", "Record video");
+    m_catalog->reload();
+    QCOMPARE(m_catalog->permission("Camera").description(), QString("Record video"));
+}
+
+namespace {
+class DescriptionReader : public QRunnable
+{
+public:
+    DescriptionReader(MPermissionCatalog *catalog, QAtomicInt *matches)
+        : m_catalog(catalog)
+        , m_matches(matches)
+    {
+    }
+
+    void run()
+    {
+        for (int i = 0; i < 100; ++i) {
+            const MPermission permission = m_catalog->permission(i % 2 ? "Camera" : "Translated");
+            if (permission.description() == (i % 2 ? "Use the camera" : "Use the network"))
+                m_matches->ref();
+        }
+    }
+
+private:
+    MPermissionCatalog *m_catalog;
+    QAtomicInt *m_matches;
+};
+}
+
+void UtMPermissionCatalog::concurrentDescriptions()
+{
+    // The translation catalog doesn't exist, so the description falls back to the untranslated one.
+    writeFile(m_directory->path() + "/Translated.permission",
+              "# x-sailjail-description = Use the network\n"
+              "# x-sailjail-translation-catalog = ut_mpermissioncatalog-missing\n"
+              "# x-sailjail-translation-key-description = permission-la-network\n");
+    m_catalog->reload();
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(4);
+    QAtomicInt matches(0);
+    for (int i = 0; i < 4; ++i)
+        pool.start(new DescriptionReader(m_catalog, &matches));
+    pool.waitForDone();
+
+    QCOMPARE(int(matches.loadAcquire()), 400);
+}
+
+QTEST_MAIN(Tests::UtMPermissionCatalog)
+
+#include "ut_mpermissioncatalog.moc"